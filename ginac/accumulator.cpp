@@ -0,0 +1,123 @@
+/** @file accumulator.cpp
+ *
+ *  Implementation of builders for sums and products. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "accumulator.h"
+#include "add.h"
+#include "mul.h"
+#include "infinity.h"
+#include "utils.h"
+
+namespace GiNaC {
+
+expairseq_accumulator::expairseq_accumulator(expairseq * p) : proto(p)
+{
+	proto->overall_coeff = proto->default_overall_coeff();
+}
+
+void expairseq_accumulator::clear()
+{
+	proto->overall_coeff = proto->default_overall_coeff();
+	terms.clear();
+	uncombined.clear();
+}
+
+void expairseq_accumulator::merge(const expair & p)
+{
+	// a numeric rest with coefficient one is a plain number
+	if (is_exactly_a<numeric>(p.rest) and ex_to<numeric>(p.coeff).is_one()) {
+		proto->combine_overall_coeff(ex_to<numeric>(p.rest));
+		return;
+	}
+	if (is_exactly_a<infinity>(p.rest)) {
+		uncombined.push_back(p);
+		return;
+	}
+	auto res = terms.emplace(p.rest, term{ex_to<numeric>(p.coeff), false});
+	if (not res.second) {
+		term & t = res.first->second;
+		t.coeff = t.coeff.add_dyn(ex_to<numeric>(p.coeff));
+		t.combined = true;
+	}
+}
+
+void expairseq_accumulator::insert(const ex & e)
+{
+	if (is_exactly_a<numeric>(e)) {
+		proto->combine_overall_coeff(ex_to<numeric>(e));
+		return;
+	}
+	// flatten objects of our own type, as make_flat() does
+	if (ex_to<basic>(e).tinfo() == proto->tinfo()) {
+		const expairseq & s = ex_to<expairseq>(e);
+		for (const auto & p : s.seq)
+			merge(p);
+		proto->combine_overall_coeff(s.overall_coeff);
+		return;
+	}
+	merge(proto->split_ex_to_pair(e));
+}
+
+void expairseq_accumulator::insert(const ex & e, const numeric & c)
+{
+	// (x*y)^c is only x^c*y^c for integer c, so ask can_make_flat()
+	if (ex_to<basic>(e).tinfo() == proto->tinfo()
+	    and proto->can_make_flat(expair(e, c))) {
+		const expairseq & s = ex_to<expairseq>(e);
+		for (const auto & p : s.seq)
+			merge(proto->combine_pair_with_coeff_to_pair(p, c));
+		merge(proto->combine_ex_with_coeff_to_pair(s.overall_coeff, c));
+		return;
+	}
+	merge(proto->combine_ex_with_coeff_to_pair(e, c));
+}
+
+ex expairseq_accumulator::result() const
+{
+	std::unique_ptr<epvector> vp(new epvector);
+	vp->reserve(terms.size() + uncombined.size());
+	for (const auto & t : terms) {
+		if (t.second.coeff.is_zero())
+			continue;
+		vp->emplace_back(t.first, t.second.coeff);
+		// Pairs that were combined may have to be rewritten, just as in
+		// expairseq::combine_same_terms_sorted_seq().  The constructor
+		// then takes care of the rewritten pairs.
+		if (t.second.combined)
+			proto->expair_needs_further_processing(vp->end() - 1);
+	}
+	vp->insert(vp->end(), uncombined.begin(), uncombined.end());
+	return proto->thisexpairseq(std::move(vp), proto->overall_coeff);
+}
+
+add_accumulator::add_accumulator() : expairseq_accumulator(new add)
+{
+}
+
+add_accumulator & add_accumulator::operator-=(const ex & e)
+{
+	insert(e, *_num_1_p);
+	return *this;
+}
+
+mul_accumulator::mul_accumulator() : expairseq_accumulator(new mul)
+{
+}
+
+} // namespace GiNaC
@@ -0,0 +1,101 @@
+/** @file accumulator.h
+ *
+ *  Interface to builders that collect the terms of a sum or the factors
+ *  of a product one by one. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_ACCUMULATOR_H__
+#define __PYNAC_ACCUMULATOR_H__
+
+#include "expairseq.h"
+#include "numeric.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace GiNaC {
+
+/** Collects expairs for an add or mul, merging the coefficients of equal
+ *  rests in a hash table as they come in.  Splitting and combining of
+ *  terms is delegated to the expairseq class that is built, so the result
+ *  is the same as with the usual constructors, but building it from n
+ *  terms takes O(n) instead of O(n^2) for repeated a = a + t. */
+class expairseq_accumulator {
+protected:
+	explicit expairseq_accumulator(expairseq * proto);
+
+	/** Insert e as a whole. */
+	void insert(const ex & e);
+	/** Insert e with coefficient c (e*c for add, e^c for mul). */
+	void insert(const ex & e, const numeric & c);
+	ex result() const;
+
+public:
+	/** Number of distinct terms collected so far. */
+	size_t size() const { return terms.size() + uncombined.size(); }
+	void clear();
+
+private:
+	void merge(const expair & p);
+
+	struct term {
+		numeric coeff;
+		bool combined;
+	};
+
+	// Only used for its semantics, and to accumulate the overall_coeff.
+	std::unique_ptr<expairseq> proto;
+	std::unordered_map<ex, term, ex_hash, ex_is_equal> terms;
+	// pairs that are never combined (infinities)
+	epvector uncombined;
+};
+
+/** Builds a sum term by term:
+ *
+ *      add_accumulator acc;
+ *      for (...)
+ *              acc += t;
+ *      ex s = acc.sum(); */
+class add_accumulator : public expairseq_accumulator {
+public:
+	add_accumulator();
+	add_accumulator & operator+=(const ex & e) { insert(e); return *this; }
+	add_accumulator & operator-=(const ex & e);
+	/** Add c*e. */
+	add_accumulator & add_term(const ex & e, const numeric & c)
+	{ insert(e, c); return *this; }
+	/** The canonical sum of everything added so far. */
+	ex sum() const { return result(); }
+};
+
+/** Builds a product factor by factor, see add_accumulator. */
+class mul_accumulator : public expairseq_accumulator {
+public:
+	mul_accumulator();
+	mul_accumulator & operator*=(const ex & e) { insert(e); return *this; }
+	/** Multiply by e^c.  A product e is split into its factors only for
+	 *  integer c, as (x*y)^(1/2) is not x^(1/2)*y^(1/2) in general. */
+	mul_accumulator & mul_factor(const ex & e, const numeric & c)
+	{ insert(e, c); return *this; }
+	/** The canonical product of everything multiplied so far. */
+	ex product() const { return result(); }
+};
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_ACCUMULATOR_H__
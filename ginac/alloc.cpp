@@ -0,0 +1,513 @@
+/** @file alloc.cpp
+ *
+ *  Pooled allocator for expression nodes.
+ *
+ *  Every basic-derived object that is created on the heap goes through
+ *  basic::operator new, i.e. through node_alloc().  Objects are sorted
+ *  into size classes of node_alloc_granularity bytes.  Each thread keeps
+ *  a free list per class and carves new objects from 64k slabs; if a free
+ *  list grows too long, a batch of it is handed to a global depot where
+ *  other threads can pick it up.  Slabs are never returned to the system,
+ *  the memory of freed nodes is reused for new nodes of the same class.
+ *
+ *  While a node_arena is active on a thread, its nodes are instead carved
+ *  from the arena's own slabs without any free lists.  Slabs are aligned
+ *  to their size and start with a header naming the owning arena, so
+ *  node_free() can tell arena memory from pooled memory.  An arena gives
+ *  all its slabs back at once when it has been left and its last node
+ *  died. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "alloc.h"
+#include "assertion.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+
+namespace GiNaC {
+
+#ifdef PYNAC_NODE_POOL
+
+namespace {
+
+const size_t num_classes = node_alloc_max_size / node_alloc_granularity;
+const size_t oversized = num_classes;   // counter index of oversized objects
+const size_t slab_size = 64 * 1024;
+const size_t batch_size = 256;          // nodes moved to the depot at once
+
+struct free_node {
+        free_node *next;
+};
+
+struct slab_header {
+        node_arena *arena;      // nullptr for slabs of the pool
+};
+
+// The header occupies the first size class slot of each slab.
+const size_t slab_header_size = node_alloc_granularity;
+static_assert(sizeof(slab_header) <= slab_header_size, "slab header too large");
+
+inline slab_header *slab_of(const void *p)
+{
+        return reinterpret_cast<slab_header *>(
+                reinterpret_cast<uintptr_t>(p) & ~uintptr_t(slab_size - 1));
+}
+
+char *alloc_slab(node_arena *owner)
+{
+        void *mem;
+        if (posix_memalign(&mem, slab_size, slab_size) != 0)
+                throw std::bad_alloc();
+        static_cast<slab_header *>(mem)->arena = owner;
+        return static_cast<char *>(mem);
+}
+
+inline size_t size_class(size_t size)
+{
+        return (size + node_alloc_granularity - 1) / node_alloc_granularity - 1;
+}
+
+inline size_t class_size(size_t c)
+{
+        return (c + 1) * node_alloc_granularity;
+}
+
+// The counters of a thread are only written by that thread, so no
+// read-modify-write is needed.  node_alloc_statistics() may read
+// slightly stale values.
+inline void bump_counter(std::atomic<long>& ctr)
+{
+        ctr.store(ctr.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+}
+
+struct thread_cache {
+        free_node *head[num_classes];
+        size_t count[num_classes];
+        char *bump[num_classes];        // unused rest of the current slab
+        char *bump_end[num_classes];
+        std::atomic<long> allocs[num_classes + 1];
+        std::atomic<long> frees[num_classes + 1];
+        thread_cache *prev, *next;      // list of all live caches
+};
+
+// The global state is only touched with depot_mutex() held.  The mutex
+// is never destroyed, as nodes may be freed by static destructors.
+std::mutex& depot_mutex()
+{
+        static std::mutex *m = new std::mutex;
+        return *m;
+}
+
+free_node *depot_head[num_classes];
+thread_cache *caches;
+long retired_allocs[num_classes + 1];
+long retired_frees[num_classes + 1];
+std::atomic<size_t> slab_bytes[num_classes];
+
+thread_local thread_cache *tcache = nullptr;
+thread_local bool tcache_retired = false;
+
+// Returns the start of the usable part of a new pool slab.
+char *new_slab(size_t c)
+{
+        slab_bytes[c].fetch_add(slab_size, std::memory_order_relaxed);
+        return alloc_slab(nullptr) + slab_header_size;
+}
+
+// Put all nodes of the list first...last to the depot.  Lock must be held.
+void depot_push(size_t c, free_node *first, free_node *last)
+{
+        last->next = depot_head[c];
+        depot_head[c] = first;
+}
+
+// Give all memory of a dying thread to the depot and fold its counters
+// into the retired ones.
+void retire_cache()
+{
+        thread_cache *tc = tcache;
+        if (tc == nullptr)
+                return;
+        std::lock_guard<std::mutex> lock(depot_mutex());
+        for (size_t c = 0; c < num_classes; ++c) {
+                if (tc->head[c] != nullptr) {
+                        free_node *last = tc->head[c];
+                        while (last->next != nullptr)
+                                last = last->next;
+                        depot_push(c, tc->head[c], last);
+                }
+                const size_t sz = class_size(c);
+                while (size_t(tc->bump_end[c] - tc->bump[c]) >= sz) {
+                        free_node *n = reinterpret_cast<free_node *>(tc->bump[c]);
+                        depot_push(c, n, n);
+                        tc->bump[c] += sz;
+                }
+        }
+        for (size_t c = 0; c <= num_classes; ++c) {
+                retired_allocs[c] += tc->allocs[c].load(std::memory_order_relaxed);
+                retired_frees[c] += tc->frees[c].load(std::memory_order_relaxed);
+        }
+        if (tc->prev != nullptr)
+                tc->prev->next = tc->next;
+        else
+                caches = tc->next;
+        if (tc->next != nullptr)
+                tc->next->prev = tc->prev;
+        delete tc;
+        tcache = nullptr;
+        tcache_retired = true;
+}
+
+struct cache_guard {
+        bool armed;
+        ~cache_guard() { retire_cache(); }
+};
+
+thread_local cache_guard guard;
+
+thread_cache *new_cache()
+{
+        thread_cache *tc = new thread_cache();
+        guard.armed = true;     // registers the guard's destructor for this thread
+        std::lock_guard<std::mutex> lock(depot_mutex());
+        tc->next = caches;
+        if (caches != nullptr)
+                caches->prev = tc;
+        caches = tc;
+        tcache = tc;
+        return tc;
+}
+
+// Returns nullptr once the thread's cache has been destroyed, which
+// happens for nodes freed by static or thread_local destructors.
+inline thread_cache *get_cache()
+{
+        if (tcache != nullptr)
+                return tcache;
+        if (tcache_retired)
+                return nullptr;
+        return new_cache();
+}
+
+void *refill(thread_cache *tc, size_t c)
+{
+        {
+                std::lock_guard<std::mutex> lock(depot_mutex());
+                free_node *first = depot_head[c];
+                if (first != nullptr) {
+                        free_node *last = first;
+                        size_t n = 1;
+                        while (n < batch_size and last->next != nullptr) {
+                                last = last->next;
+                                ++n;
+                        }
+                        depot_head[c] = last->next;
+                        last->next = nullptr;
+                        tc->head[c] = first->next;
+                        tc->count[c] = n - 1;
+                        return first;
+                }
+        }
+        const size_t sz = class_size(c);
+        if (size_t(tc->bump_end[c] - tc->bump[c]) < sz) {
+                tc->bump[c] = new_slab(c);
+                tc->bump_end[c] = tc->bump[c] + (slab_size - slab_header_size);
+        }
+        void *p = tc->bump[c];
+        tc->bump[c] += sz;
+        return p;
+}
+
+// Move the first n nodes of the thread's free list to the depot.
+void give_back(thread_cache *tc, size_t c, size_t n)
+{
+        free_node *first = tc->head[c], *last = first;
+        for (size_t i = 1; i < n; ++i)
+                last = last->next;
+        tc->head[c] = last->next;
+        tc->count[c] -= n;
+        std::lock_guard<std::mutex> lock(depot_mutex());
+        depot_push(c, first, last);
+}
+
+void *depot_alloc(size_t c)
+{
+        std::lock_guard<std::mutex> lock(depot_mutex());
+        ++retired_allocs[c];
+        free_node *n = depot_head[c];
+        if (n != nullptr) {
+                depot_head[c] = n->next;
+                return n;
+        }
+        const size_t sz = class_size(c);
+        char *slab = new_slab(c);
+        for (size_t off = sz; off + sz <= slab_size - slab_header_size; off += sz) {
+                free_node *m = reinterpret_cast<free_node *>(slab + off);
+                depot_push(c, m, m);
+        }
+        return slab;
+}
+
+void depot_free(size_t c, void *p)
+{
+        std::lock_guard<std::mutex> lock(depot_mutex());
+        ++retired_frees[c];
+        free_node *n = static_cast<free_node *>(p);
+        depot_push(c, n, n);
+}
+
+void count_oversized(bool alloc)
+{
+        thread_cache *tc = get_cache();
+        if (tc != nullptr) {
+                bump_counter(alloc ? tc->allocs[oversized] : tc->frees[oversized]);
+                return;
+        }
+        std::lock_guard<std::mutex> lock(depot_mutex());
+        ++(alloc ? retired_allocs[oversized] : retired_frees[oversized]);
+}
+
+} // anonymous namespace
+
+struct node_arena {
+        node_arena *outer;              // arena that was active before
+        char *bump, *bump_end;
+        std::unordered_set<uintptr_t> slabs;
+        // live nodes, plus one as long as the arena has not been left
+        std::atomic<long> refs;
+};
+
+namespace {
+
+thread_local node_arena *current_arena = nullptr;
+
+void *arena_alloc(node_arena *a, size_t size)
+{
+        size = (size + node_alloc_granularity - 1)
+                / node_alloc_granularity * node_alloc_granularity;
+        if (size_t(a->bump_end - a->bump) < size) {
+                char *slab = alloc_slab(a);
+                a->slabs.insert(reinterpret_cast<uintptr_t>(slab));
+                a->bump = slab + slab_header_size;
+                a->bump_end = slab + slab_size;
+        }
+        void *p = a->bump;
+        a->bump += size;
+        a->refs.fetch_add(1, std::memory_order_relaxed);
+        return p;
+}
+
+void arena_release(node_arena *a)
+{
+        if (a->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+        for (uintptr_t slab : a->slabs)
+                free(reinterpret_cast<void *>(slab));
+        delete a;
+}
+
+} // anonymous namespace
+
+node_arena *node_arena_enter()
+{
+        node_arena *a = new node_arena;
+        a->outer = current_arena;
+        a->bump = a->bump_end = nullptr;
+        a->refs.store(1, std::memory_order_relaxed);
+        current_arena = a;
+        return a;
+}
+
+void node_arena_leave(node_arena *a)
+{
+        GINAC_ASSERT(current_arena == a);
+        current_arena = a->outer;
+        arena_release(a);
+}
+
+node_arena *node_arena_switch(node_arena *a)
+{
+        node_arena *prev = current_arena;
+        current_arena = a;
+        return prev;
+}
+
+node_arena *node_arena_outer(const node_arena *a)
+{
+        return a->outer;
+}
+
+bool node_arena_owns(const node_arena *a, const void *p)
+{
+        return a->slabs.count(reinterpret_cast<uintptr_t>(slab_of(p))) != 0;
+}
+
+size_t node_arena_bytes(const node_arena *a)
+{
+        return a->slabs.size() * slab_size;
+}
+
+void *node_alloc(size_t size)
+{
+        if (size > node_alloc_max_size) {
+                void *p = ::operator new(size);
+                count_oversized(true);
+                return p;
+        }
+        if (current_arena != nullptr)
+                return arena_alloc(current_arena, size);
+        const size_t c = size_class(size);
+        thread_cache *tc = get_cache();
+        if (tc == nullptr)
+                return depot_alloc(c);
+        bump_counter(tc->allocs[c]);
+        free_node *n = tc->head[c];
+        if (n == nullptr)
+                return refill(tc, c);
+        tc->head[c] = n->next;
+        --tc->count[c];
+        return n;
+}
+
+void node_free(void *p, size_t size)
+{
+        if (p == nullptr)
+                return;
+        if (size > node_alloc_max_size) {
+                ::operator delete(p);
+                count_oversized(false);
+                return;
+        }
+        node_arena *a = slab_of(p)->arena;
+        if (a != nullptr) {
+                arena_release(a);
+                return;
+        }
+        const size_t c = size_class(size);
+        thread_cache *tc = get_cache();
+        if (tc == nullptr) {
+                depot_free(c, p);
+                return;
+        }
+        bump_counter(tc->frees[c]);
+        free_node *n = static_cast<free_node *>(p);
+        n->next = tc->head[c];
+        tc->head[c] = n;
+        if (++tc->count[c] >= 2 * batch_size)
+                give_back(tc, c, batch_size);
+}
+
+std::vector<node_alloc_stat> node_alloc_statistics()
+{
+        long allocs[num_classes + 1], frees[num_classes + 1];
+        std::lock_guard<std::mutex> lock(depot_mutex());
+        for (size_t c = 0; c <= num_classes; ++c) {
+                allocs[c] = retired_allocs[c];
+                frees[c] = retired_frees[c];
+        }
+        for (thread_cache *tc = caches; tc != nullptr; tc = tc->next)
+                for (size_t c = 0; c <= num_classes; ++c) {
+                        allocs[c] += tc->allocs[c].load(std::memory_order_relaxed);
+                        frees[c] += tc->frees[c].load(std::memory_order_relaxed);
+                }
+
+        std::vector<node_alloc_stat> v;
+        v.reserve(num_classes + 1);
+        for (size_t c = 0; c <= num_classes; ++c) {
+                node_alloc_stat s;
+                s.size = c == oversized ? 0 : class_size(c);
+                s.live = allocs[c] - frees[c];
+                s.total = allocs[c];
+                s.slab_bytes = c == oversized ? 0
+                        : slab_bytes[c].load(std::memory_order_relaxed);
+                v.push_back(s);
+        }
+        return v;
+}
+
+#else // PYNAC_NODE_POOL
+
+struct node_arena {
+        node_arena *outer;
+};
+
+namespace {
+
+thread_local node_arena *current_arena = nullptr;
+
+} // anonymous namespace
+
+node_arena *node_arena_enter()
+{
+        node_arena *a = new node_arena;
+        a->outer = current_arena;
+        current_arena = a;
+        return a;
+}
+
+void node_arena_leave(node_arena *a)
+{
+        current_arena = a->outer;
+        delete a;
+}
+
+node_arena *node_arena_switch(node_arena *a)
+{
+        node_arena *prev = current_arena;
+        current_arena = a;
+        return prev;
+}
+
+node_arena *node_arena_outer(const node_arena *a)
+{
+        return a->outer;
+}
+
+bool node_arena_owns(const node_arena *a, const void *p)
+{
+        return false;
+}
+
+size_t node_arena_bytes(const node_arena *a)
+{
+        return 0;
+}
+
+void *node_alloc(size_t size)
+{
+        return ::operator new(size);
+}
+
+void node_free(void *p, size_t size)
+{
+        ::operator delete(p);
+}
+
+std::vector<node_alloc_stat> node_alloc_statistics()
+{
+        return std::vector<node_alloc_stat>();
+}
+
+#endif // PYNAC_NODE_POOL
+
+} // namespace GiNaC
@@ -0,0 +1,89 @@
+/** @file alloc.h
+ *
+ *  Interface to the pooled allocator for expression nodes. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_ALLOC_H__
+#define __PYNAC_ALLOC_H__
+
+#include "pynac-config.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace GiNaC {
+
+/** Objects of up to this many bytes are served from per-size-class slabs,
+ *  larger ones come directly from the global operator new. */
+const size_t node_alloc_max_size = 256;
+
+/** Distance between neighbouring size classes. */
+const size_t node_alloc_granularity = 16;
+
+/** Allocate memory for a basic-derived object.
+ *  @see basic::operator new */
+void *node_alloc(size_t size);
+
+/** Give back memory obtained from node_alloc().  The size must be the
+ *  one that was passed to node_alloc(). */
+void node_free(void *p, size_t size);
+
+/** Allocation counters of one size class. */
+struct node_alloc_stat {
+        size_t size;            ///< object size of this class, 0 for oversized objects
+        long live;              ///< objects currently allocated
+        long total;             ///< objects allocated since program start
+        size_t slab_bytes;      ///< memory taken from the system for this class
+};
+
+/** Return the counters of all size classes, summed over all threads.
+ *  Without the node pool (configure --disable-node-pool) this is empty. */
+std::vector<node_alloc_stat> node_alloc_statistics();
+
+/** Memory region from which the nodes of one expression_arena are served.
+ *  Nodes allocated in an arena are never reused individually; all memory
+ *  of the arena is released together once the arena has been left and
+ *  none of its nodes is alive any more.  Without the node pool, arenas
+ *  exist but do not own any memory. */
+struct node_arena;
+
+/** Create an arena and make it the current one of this thread.  All
+ *  node_alloc() calls of this thread are served from it until it is left
+ *  or another arena is entered. */
+node_arena *node_arena_enter();
+
+/** Stop using the arena, which must be the current one, and make the one
+ *  that was current before entering it current again. */
+void node_arena_leave(node_arena *a);
+
+/** Make a (which may be nullptr, for no arena) the current arena of this
+ *  thread without leaving the current one.  Returns the previous one. */
+node_arena *node_arena_switch(node_arena *a);
+
+/** Return the arena that was current when a was entered. */
+node_arena *node_arena_outer(const node_arena *a);
+
+/** Whether p points into memory of the arena. */
+bool node_arena_owns(const node_arena *a, const void *p);
+
+/** Memory taken from the system by the arena so far. */
+size_t node_arena_bytes(const node_arena *a);
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_ALLOC_H__
@@ -0,0 +1,62 @@
+/** @file arena.cpp
+ *
+ *  Implementation of scoped expression arenas. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "arena.h"
+#include "basic.h"
+
+namespace GiNaC {
+
+namespace {
+
+/** Copies every node of the arena that is reachable through the operands
+ *  of an expression.  The map of containers only copies a node if one of
+ *  its operands changed, so nodes of the arena whose operands all live
+ *  outside of it are duplicated here. */
+struct promote_map_function : public map_function {
+        const expression_arena & arena;
+        explicit promote_map_function(const expression_arena & a) : arena(a) {}
+        ex operator()(const ex & e) override
+        {
+                ex r = e.nops() == 0 ? e : e.map(*this);
+                if (not arena.owns(r))
+                        return r;
+                basic *copy = ex_to<basic>(r).duplicate();
+                copy->setflag(status_flags::dynallocated);
+                return *copy;
+        }
+};
+
+// Switches the thread to another arena for the lifetime of the object.
+struct arena_switch {
+        node_arena *saved;
+        explicit arena_switch(node_arena *a) : saved(node_arena_switch(a)) {}
+        ~arena_switch() { node_arena_switch(saved); }
+};
+
+} // anonymous namespace
+
+ex expression_arena::promote(const ex & e) const
+{
+        arena_switch s(node_arena_outer(a));
+        promote_map_function f(*this);
+        return f(e);
+}
+
+} // namespace GiNaC
@@ -0,0 +1,71 @@
+/** @file arena.h
+ *
+ *  Interface to scoped expression arenas. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_ARENA_H__
+#define __PYNAC_ARENA_H__
+
+#include "ex.h"
+#include "alloc.h"
+
+namespace GiNaC {
+
+/** While an object of this class exists, all expression nodes created by
+ *  the thread that created it are bump-allocated from a private arena.
+ *  The memory of the arena is released in one go when the scope has ended
+ *  and no node of the arena is referenced any more.  Nodes that are still
+ *  referenced keep the whole arena alive, so the result of a computation
+ *  should be copied out with promote() before the scope ends:
+ *
+ *      ex result;
+ *      {
+ *              expression_arena scope;
+ *              ex tmp = big_computation();
+ *              result = scope.promote(tmp);
+ *      }
+ *
+ *  Arenas nest; the innermost one is used.  Without the node pool
+ *  (configure --disable-node-pool) arenas have no effect. */
+class expression_arena {
+public:
+        expression_arena() : a(node_arena_enter()) {}
+        ~expression_arena() { node_arena_leave(a); }
+
+        expression_arena(const expression_arena &) = delete;
+        expression_arena & operator=(const expression_arena &) = delete;
+
+        /** Return a copy of e that shares no nodes with this arena.  The
+         *  copy lives in the enclosing arena, or on the heap if there is
+         *  none. */
+        ex promote(const ex & e) const;
+
+        /** Whether the top node of e lives in this arena. */
+        bool owns(const ex & e) const
+        { return node_arena_owns(a, &ex_to<basic>(e)); }
+
+        /** Memory taken from the system by this arena so far. */
+        size_t bytes() const { return node_arena_bytes(a); }
+
+private:
+        node_arena *a;
+};
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_ARENA_H__
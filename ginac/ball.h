@@ -0,0 +1,54 @@
+/** @file ball.h
+ *
+ *  Layout of the Arb balls held by numeric.  This header is internal, so
+ *  that the installed headers do not depend on Arb. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_BALL_H__
+#define __PYNAC_BALL_H__
+
+#include "numeric.h"
+
+#include <acb.h>
+
+namespace GiNaC {
+
+struct ball_struct {
+        acb_struct z;
+        slong prec;
+};
+
+// Balls are allocated separately, like complex numbers, so that they do
+// not make every numeric larger.  ball_clear() frees what ball_init()
+// allocates, and numeric(ball_ptr) takes a ball over.
+inline void ball_init(ball_ptr& b, slong prec)
+{
+        b = new ball_struct;
+        acb_init(&b->z);
+        b->prec = prec;
+}
+
+inline void ball_clear(ball_ptr b)
+{
+        acb_clear(&b->z);
+        delete b;
+}
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_BALL_H__
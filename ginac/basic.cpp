@@ -37,6 +37,8 @@
 #include "inifcns.h"
 
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 #ifdef DO_GINAC_ASSERT
 #  include <typeinfo>
@@ -58,14 +60,16 @@ GINAC_IMPLEMENT_REGISTERED_CLASS_OPT(basic, void,
 /** basic copy constructor: implicitly assumes that the other class is of
  *  the exact same type (as it's used by duplicate()), so it can copy the
  *  tinfo_key and the hash value. */
-basic::basic(const basic & other) : tinfo_key(other.tinfo_key), flags(other.flags & ~status_flags::dynallocated), hashvalue(other.hashvalue)
+basic::basic(const basic & other) : tinfo_key(other.tinfo_key), flags(other.flags & ~(status_flags::dynallocated | status_flags::interned)), hashvalue(static_cast<long>(other.hashvalue))
 {
 }
 
 /** basic assignment operator: the other object might be of a derived class. */
 const basic & basic::operator=(const basic & other)
 {
-	unsigned fl = other.flags & ~status_flags::dynallocated;
+	if ((flags & status_flags::interned) != 0u)
+		remove_from_unique_table(*this);
+	unsigned fl = other.flags & ~(status_flags::dynallocated | status_flags::interned);
 	if (tinfo_key != other.tinfo_key) {
 		// The other object is of a derived class, so clear the flags as they
 		// might no longer apply (especially hash_calculated). Oh, and don't
@@ -73,7 +77,7 @@ const basic & basic::operator=(const basic & other)
 		fl &= ~(status_flags::evaluated | status_flags::expanded | status_flags::hash_calculated);
 	} else {
 		// The objects are of the exact same class, so copy the hash value.
-		hashvalue = other.hashvalue;
+		hashvalue = static_cast<long>(other.hashvalue);
 	}
 	flags = fl;
 	set_refcount(0);
@@ -765,8 +769,8 @@ long basic::calchash() const
 
 	// store calculated hash value only if object is already evaluated
 	if (is_evaluated()) {
-		setflag(status_flags::hash_calculated);
 		hashvalue = v;
+		setflag(status_flags::hash_calculated);
 	}
 
 	return v;
@@ -803,23 +807,17 @@ ex basic::expand(unsigned options) const
  *  1 greater. */
 int basic::compare(const basic & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_basic_compares++;
-#endif
+	GINAC_COUNT_COMPARE(cc_total_basic_compares);
 	const long hash_this = gethash();
 	const long hash_other = other.gethash();
 	if (hash_this<hash_other) return -1;
 	if (hash_this>hash_other) return 1;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.compare_same_hashvalue++;
-#endif
+	GINAC_COUNT_COMPARE(cc_compare_same_hashvalue);
 
 	const tinfo_t& typeid_this = tinfo();
 	const tinfo_t& typeid_other = other.tinfo();
 	if (typeid_this == typeid_other) {
-#ifdef GINAC_COMPARE_STATISTICS
-		compare_statistics.compare_same_type++;
-#endif
+		GINAC_COUNT_COMPARE(cc_compare_same_type);
 		return compare_same_type(other);
 	} 
         return (typeid_this<typeid_other ? -1 : 1);
@@ -833,22 +831,16 @@ int basic::compare(const basic & other) const
  *  @see is_equal_same_type */
 bool basic::is_equal(const basic & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_basic_is_equals++;
-#endif
+	GINAC_COUNT_COMPARE(cc_total_basic_is_equals);
 	if (this->gethash()!=other.gethash())
 		return false;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.is_equal_same_hashvalue++;
-#endif
+	GINAC_COUNT_COMPARE(cc_is_equal_same_hashvalue);
 	if (this->tinfo()!=other.tinfo())
 		return false;
 	
 	GINAC_ASSERT(typeid(*this)==typeid(other));
 	
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.is_equal_same_type++;
-#endif
+	GINAC_COUNT_COMPARE(cc_is_equal_same_type);
 	return is_equal_same_type(other);
 }
 
@@ -868,6 +860,8 @@ void basic::ensure_if_modifiable() const
 {
 	if (get_refcount() > 1)
 		throw(std::runtime_error("cannot modify multiply referenced object"));
+	if ((flags & status_flags::interned) != 0u)
+		remove_from_unique_table(*this);
 	clearflag(status_flags::hash_calculated | status_flags::evaluated);
 }
 
@@ -878,26 +872,187 @@ void basic::ensure_if_modifiable() const
 int max_recursion_level = 1024;
 
 
-#ifdef GINAC_COMPARE_STATISTICS
-compare_statistics_t::~compare_statistics_t()
+//////////
+// compare statistics
+//////////
+
+namespace {
+
+const char *compare_counter_names[cc_num_counters] = {
+	"total_compares",
+	"nontrivial_compares",
+	"total_basic_compares",
+	"compare_same_hashvalue",
+	"compare_same_type",
+	"total_is_equals",
+	"nontrivial_is_equals",
+	"total_basic_is_equals",
+	"is_equal_same_hashvalue",
+	"is_equal_same_type",
+	"total_gethash",
+	"gethash_cached",
+};
+
+// Counters of one thread.  Only the owning thread writes them, other
+// threads read them when the statistics are summed up.
+struct compare_counters {
+	std::atomic<unsigned long> ctr[cc_num_counters];
+	compare_counters *prev, *next;
+};
+
+// Global state, only touched with stats_mutex() held.  Neither the mutex
+// nor the counters are ever destroyed, as threads may still count while
+// static objects are destroyed.
+std::mutex & stats_mutex()
 {
-	std::clog << "ex::compare() called " << total_compares << " times" << std::endl;
-	std::clog << "nontrivial compares: " << nontrivial_compares << " times" << std::endl;
-	std::clog << "basic::compare() called " << total_basic_compares << " times" << std::endl;
-	std::clog << "same hashvalue in compare(): " << compare_same_hashvalue << " times" << std::endl;
-	std::clog << "compare_same_type() called " << compare_same_type << " times" << std::endl;
-	std::clog << std::endl;
-	std::clog << "ex::is_equal() called " << total_is_equals << " times" << std::endl;
-	std::clog << "nontrivial is_equals: " << nontrivial_is_equals << " times" << std::endl;
-	std::clog << "basic::is_equal() called " << total_basic_is_equals << " times" << std::endl;
-	std::clog << "same hashvalue in is_equal(): " << is_equal_same_hashvalue << " times" << std::endl;
-	std::clog << "is_equal_same_type() called " << is_equal_same_type << " times" << std::endl;
-	std::clog << std::endl;
-	std::clog << "basic::gethash() called " << total_gethash << " times" << std::endl;
-	std::clog << "used cached hashvalue " << gethash_cached << " times" << std::endl;
+	static std::mutex *m = new std::mutex;
+	return *m;
 }
 
-compare_statistics_t compare_statistics;
-#endif
+compare_counters *all_counters;
+compare_statistics_t retired_counts, reset_counts;
+
+thread_local compare_counters *my_counters = nullptr;
+thread_local bool counters_retired = false;
+
+void sum_counts(compare_statistics_t & s)
+{
+	for (compare_counters *cc = all_counters; cc != nullptr; cc = cc->next)
+		for (int c = 0; c < cc_num_counters; ++c)
+			s[compare_counter(c)] += cc->ctr[c].load(std::memory_order_relaxed);
+}
+
+struct counters_guard {
+	bool armed;
+	~counters_guard()
+	{
+		compare_counters *cc = my_counters;
+		if (cc == nullptr)
+			return;
+		std::lock_guard<std::mutex> lock(stats_mutex());
+		for (int c = 0; c < cc_num_counters; ++c)
+			retired_counts[compare_counter(c)] += cc->ctr[c].load(std::memory_order_relaxed);
+		if (cc->prev != nullptr)
+			cc->prev->next = cc->next;
+		else
+			all_counters = cc->next;
+		if (cc->next != nullptr)
+			cc->next->prev = cc->prev;
+		delete cc;
+		my_counters = nullptr;
+		counters_retired = true;	// drop events from now on
+	}
+};
+
+thread_local counters_guard stats_guard;
+
+} // anonymous namespace
+
+std::atomic<bool> compare_statistics_on(false);
+
+compare_statistics_t::compare_statistics_t()
+ : total_compares(0), nontrivial_compares(0), total_basic_compares(0), compare_same_hashvalue(0), compare_same_type(0),
+   total_is_equals(0), nontrivial_is_equals(0), total_basic_is_equals(0), is_equal_same_hashvalue(0), is_equal_same_type(0),
+   total_gethash(0), gethash_cached(0) {}
+
+unsigned long & compare_statistics_t::operator[](compare_counter c)
+{
+	switch (c) {
+	case cc_total_compares: return total_compares;
+	case cc_nontrivial_compares: return nontrivial_compares;
+	case cc_total_basic_compares: return total_basic_compares;
+	case cc_compare_same_hashvalue: return compare_same_hashvalue;
+	case cc_compare_same_type: return compare_same_type;
+	case cc_total_is_equals: return total_is_equals;
+	case cc_nontrivial_is_equals: return nontrivial_is_equals;
+	case cc_total_basic_is_equals: return total_basic_is_equals;
+	case cc_is_equal_same_hashvalue: return is_equal_same_hashvalue;
+	case cc_is_equal_same_type: return is_equal_same_type;
+	case cc_total_gethash: return total_gethash;
+	case cc_gethash_cached: return gethash_cached;
+	default:
+		throw std::out_of_range("compare_statistics_t: no such counter");
+	}
+}
+
+unsigned long compare_statistics_t::operator[](compare_counter c) const
+{
+	return const_cast<compare_statistics_t &>(*this)[c];
+}
+
+void compare_statistics_t::print(std::ostream & os) const
+{
+	os << "ex::compare() called " << total_compares << " times" << std::endl;
+	os << "nontrivial compares: " << nontrivial_compares << " times" << std::endl;
+	os << "basic::compare() called " << total_basic_compares << " times" << std::endl;
+	os << "same hashvalue in compare(): " << compare_same_hashvalue << " times" << std::endl;
+	os << "compare_same_type() called " << compare_same_type << " times" << std::endl;
+	os << std::endl;
+	os << "ex::is_equal() called " << total_is_equals << " times" << std::endl;
+	os << "nontrivial is_equals: " << nontrivial_is_equals << " times" << std::endl;
+	os << "basic::is_equal() called " << total_basic_is_equals << " times" << std::endl;
+	os << "same hashvalue in is_equal(): " << is_equal_same_hashvalue << " times" << std::endl;
+	os << "is_equal_same_type() called " << is_equal_same_type << " times" << std::endl;
+	os << std::endl;
+	os << "basic::gethash() called " << total_gethash << " times" << std::endl;
+	os << "used cached hashvalue " << gethash_cached << " times" << std::endl;
+}
+
+std::string compare_statistics_t::to_json() const
+{
+	std::ostringstream os;
+	os << '{';
+	for (int c = 0; c < cc_num_counters; ++c) {
+		if (c != 0)
+			os << ", ";
+		os << '"' << compare_counter_names[c] << "\": "
+		   << (*this)[compare_counter(c)];
+	}
+	os << '}';
+	return os.str();
+}
+
+void set_compare_statistics(bool enable)
+{
+	compare_statistics_on.store(enable, std::memory_order_relaxed);
+}
+
+compare_statistics_t compare_statistics()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex());
+	compare_statistics_t s = retired_counts;
+	sum_counts(s);
+	for (int c = 0; c < cc_num_counters; ++c)
+		s[compare_counter(c)] -= reset_counts[compare_counter(c)];
+	return s;
+}
+
+void reset_compare_statistics()
+{
+	// Remember the current totals instead of clearing the counters, which
+	// would race with the threads counting.
+	std::lock_guard<std::mutex> lock(stats_mutex());
+	reset_counts = retired_counts;
+	sum_counts(reset_counts);
+}
+
+void count_compare_event(compare_counter c)
+{
+	compare_counters *cc = my_counters;
+	if (cc == nullptr) {
+		if (counters_retired)
+			return;
+		cc = new compare_counters();
+		stats_guard.armed = true;	// registers the guard's destructor
+		std::lock_guard<std::mutex> lock(stats_mutex());
+		cc->next = all_counters;
+		if (all_counters != nullptr)
+			all_counters->prev = cc;
+		all_counters = cc;
+		my_counters = cc;
+	}
+	std::atomic<unsigned long> & ctr = cc->ctr[c];
+	ctr.store(ctr.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
 
 } // namespace GiNaC
@@ -29,8 +29,12 @@
 #include <unordered_map>
 // CINT needs <algorithm> to work properly with <vector>
 #include <algorithm>
+#include <atomic>
+#include <iosfwd>
+#include <string>
 
 #include "pynac-config.h"
+#include "alloc.h"
 #include "flags.h"
 #include "ptr.h"
 #include "assertion.h"
@@ -74,17 +78,29 @@ typedef std::map<ex, ex, ex_is_less> exmap;
 using ex_int_map = std::map<GiNaC::ex, int, GiNaC::ex_is_less>;
 using ex_int_umap = std::unordered_map<ex, int, ex_hash>;
 
-// Define this to enable some statistical output for comparisons and hashing
-#undef GINAC_COMPARE_STATISTICS
+/** Indices of the counters of compare_statistics_t. */
+enum compare_counter {
+	cc_total_compares,
+	cc_nontrivial_compares,
+	cc_total_basic_compares,
+	cc_compare_same_hashvalue,
+	cc_compare_same_type,
+	cc_total_is_equals,
+	cc_nontrivial_is_equals,
+	cc_total_basic_is_equals,
+	cc_is_equal_same_hashvalue,
+	cc_is_equal_same_type,
+	cc_total_gethash,
+	cc_gethash_cached,
+	cc_num_counters
+};
 
-#ifdef GINAC_COMPARE_STATISTICS
+/** Statistics about comparisons and hashing of expressions.  They are only
+ *  collected while switched on with set_compare_statistics(); each thread
+ *  counts for itself and compare_statistics() adds them up. */
 class compare_statistics_t {
 public:
-	compare_statistics_t()
-	 : total_compares(0), nontrivial_compares(0), total_basic_compares(0), compare_same_hashvalue(0), compare_same_type(0),
-	   total_is_equals(0), nontrivial_is_equals(0), total_basic_is_equals(0), is_equal_same_hashvalue(0), is_equal_same_type(0),
-	   total_gethash(0), gethash_cached(0) {}
-	~compare_statistics_t();
+	compare_statistics_t();
 
 	unsigned long total_compares;
 	unsigned long nontrivial_compares;
@@ -100,10 +116,40 @@ public:
 
 	unsigned long total_gethash;
 	unsigned long gethash_cached;
+
+	unsigned long & operator[](compare_counter c);
+	unsigned long operator[](compare_counter c) const;
+
+	void print(std::ostream & os) const;
+	/** One JSON object with a member per counter. */
+	std::string to_json() const;
 };
 
-extern compare_statistics_t compare_statistics;
-#endif
+extern std::atomic<bool> compare_statistics_on;
+
+/** Switch collection of compare statistics on or off.  Off by default. */
+void set_compare_statistics(bool enable);
+inline bool compare_statistics_enabled()
+{
+	return compare_statistics_on.load(std::memory_order_relaxed);
+}
+/** Return the counters of all threads since the last reset. */
+compare_statistics_t compare_statistics();
+/** Start counting from zero again. */
+void reset_compare_statistics();
+
+void count_compare_event(compare_counter c);
+
+#define GINAC_COUNT_COMPARE(c) \
+	do { \
+		if (compare_statistics_enabled()) \
+			count_compare_event(c); \
+	} while (false)
+
+
+/** Remove an object from the hash-consing table.
+ *  @see set_hash_consing() */
+void remove_from_unique_table(const basic & obj);
 
 
 /** Function object for map(). */
@@ -160,10 +206,19 @@ public:
 	virtual ~basic()
 	{
 		GINAC_ASSERT((!(flags & status_flags::dynallocated)) || (get_refcount() == 0));
+		if ((flags & status_flags::interned) != 0u)
+			remove_from_unique_table(*this);
 	}
 	basic(const basic & other);
 	const basic & operator=(const basic & other);
 
+	/** Heap-allocated objects come from the node pools.  The size passed
+	 *  to operator delete is that of the dynamic type, since the destructor
+	 *  is virtual.
+	 *  @see alloc.cpp */
+	static void * operator new(size_t size) { return node_alloc(size); }
+	static void operator delete(void * p, size_t size) { node_free(p, size); }
+
 protected:
 	/** Constructor with specified tinfo_key (used by derived classes instead
 	 *  of the default constructor to avoid assigning tinfo_key twice). */
@@ -294,25 +349,40 @@ public:
         void set_epseq_from(size_t i, ex e);
 	long gethash() const
 	{
-#ifdef GINAC_COMPARE_STATISTICS
-		compare_statistics.total_gethash++;
-#endif
+		GINAC_COUNT_COMPARE(cc_total_gethash);
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+		// pairs with the release in setflag(): whoever sees
+		// hash_calculated also sees the hashvalue stored before it
+		if (flags.load(std::memory_order_acquire) & status_flags::hash_calculated) {
+			GINAC_COUNT_COMPARE(cc_gethash_cached);
+			return hashvalue.load(std::memory_order_relaxed);
+		}
+#else
 		if (flags & status_flags::hash_calculated) {
-#ifdef GINAC_COMPARE_STATISTICS
-			compare_statistics.gethash_cached++;
-#endif
+			GINAC_COUNT_COMPARE(cc_gethash_cached);
 			return hashvalue;
 		} 
+#endif
                 return calchash();
 	}
 
 	tinfo_t tinfo() const {return tinfo_key;}
 
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+	/** Set some status_flags.  Evaluated objects may be read by several
+	 *  threads, which all cache their findings here, so the flags are
+	 *  updated atomically and published with release ordering. */
+	const basic & setflag(unsigned f) const {flags.fetch_or(f, std::memory_order_release); return *this;}
+
+	/** Clear some status_flags. */
+	const basic & clearflag(unsigned f) const {flags.fetch_and(~f, std::memory_order_release); return *this;}
+#else
 	/** Set some status_flags. */
 	const basic & setflag(unsigned f) const {flags |= f; return *this;}
 
 	/** Clear some status_flags. */
 	const basic & clearflag(unsigned f) const {flags &= ~f; return *this;}
+#endif
 
 	void ensure_if_modifiable() const;
 #ifdef PYNAC_HAVE_LIBGIAC
@@ -321,8 +391,14 @@ public:
 
 	// member variables
 	tinfo_t tinfo_key;                  ///< type info
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+	// hashvalue must be stored before hash_calculated is set
+	mutable std::atomic<unsigned> flags; ///< of type status_flags
+	mutable std::atomic<long> hashvalue{0}; ///< hash value
+#else
 	mutable unsigned flags;             ///< of type status_flags
 	mutable long hashvalue=0;         ///< hash value
+#endif
 };
 
 
@@ -0,0 +1,498 @@
+/** @file compiled_ex.cpp
+ *
+ *  Compilation of expressions into bytecode and its evaluation. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "compiled_ex.h"
+#include "evalf_double.h"
+#include "numeric.h"
+#include "add.h"
+#include "mul.h"
+#include "power.h"
+#include "symbol.h"
+#include "constant.h"
+#include "function.h"
+#include "inifcns.h"
+#include "parallel.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace GiNaC {
+
+using cdouble = std::complex<double>;
+using mpfr_kernel_t = int (*)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t);
+
+static int factorial_mpfr(mpfr_ptr r, mpfr_srcptr x, mpfr_rnd_t rnd)
+{
+        mpfr_add_si(r, x, 1, rnd);
+        return mpfr_gamma(r, r, rnd);
+}
+
+// the inverse reciprocal functions, f(x) = g(1/x)
+template <mpfr_kernel_t g>
+static int inverse_mpfr(mpfr_ptr r, mpfr_srcptr x, mpfr_rnd_t rnd)
+{
+        mpfr_ui_div(r, 1, x, rnd);
+        return g(r, r, rnd);
+}
+
+using funcmap_t = std::unordered_map<unsigned int,mpfr_kernel_t>;
+
+// Every function that can be compiled has an MPFR kernel.
+static funcmap_t& funcmap()
+{
+        static funcmap_t _funcmap = {{
+                {exp_SERIAL::serial, &mpfr_exp},
+                {log_SERIAL::serial, &mpfr_log},
+                {sin_SERIAL::serial, &mpfr_sin},
+                {cos_SERIAL::serial, &mpfr_cos},
+                {tan_SERIAL::serial, &mpfr_tan},
+                {cot_SERIAL::serial, &mpfr_cot},
+                {sec_SERIAL::serial, &mpfr_sec},
+                {csc_SERIAL::serial, &mpfr_csc},
+                {asin_SERIAL::serial, &mpfr_asin},
+                {acos_SERIAL::serial, &mpfr_acos},
+                {atan_SERIAL::serial, &mpfr_atan},
+                {acot_SERIAL::serial, &inverse_mpfr<mpfr_atan>},
+                {asec_SERIAL::serial, &inverse_mpfr<mpfr_acos>},
+                {acsc_SERIAL::serial, &inverse_mpfr<mpfr_asin>},
+                {sinh_SERIAL::serial, &mpfr_sinh},
+                {cosh_SERIAL::serial, &mpfr_cosh},
+                {tanh_SERIAL::serial, &mpfr_tanh},
+                {coth_SERIAL::serial, &mpfr_coth},
+                {sech_SERIAL::serial, &mpfr_sech},
+                {csch_SERIAL::serial, &mpfr_csch},
+                {asinh_SERIAL::serial, &mpfr_asinh},
+                {acosh_SERIAL::serial, &mpfr_acosh},
+                {atanh_SERIAL::serial, &mpfr_atanh},
+                {acoth_SERIAL::serial, &inverse_mpfr<mpfr_atanh>},
+                {asech_SERIAL::serial, &inverse_mpfr<mpfr_acosh>},
+                {acsch_SERIAL::serial, &inverse_mpfr<mpfr_asinh>},
+                {abs_SERIAL::serial, &mpfr_abs},
+                {gamma_SERIAL::serial, &mpfr_gamma},
+                {lgamma_SERIAL::serial, &mpfr_lngamma},
+                {factorial_SERIAL::serial, &factorial_mpfr},
+                {psi1_SERIAL::serial, &mpfr_digamma},
+                {zeta1_SERIAL::serial, &mpfr_zeta},
+                {Li2_SERIAL::serial, &mpfr_li2},
+        }};
+
+        return _funcmap;
+}
+
+/** Lowers an expression into the code of a compiled_ex.  Every distinct
+ *  subexpression gets its own register. */
+class bytecode_compiler {
+public:
+        bytecode_compiler(compiled_ex& c, const lst& args);
+        unsigned compile(const ex& e);
+private:
+        unsigned emit(compiled_ex::opcode op, unsigned a, unsigned b = 0,
+                      long n = 0);
+        unsigned compile_new(const ex& e);
+        compiled_ex& ce;
+        std::unordered_map<ex, unsigned, ex_hash, ex_is_equal> regs;
+        std::unordered_map<unsigned, long> kernel_index;
+};
+
+bytecode_compiler::bytecode_compiler(compiled_ex& c, const lst& args)
+  : ce(c)
+{
+        for (size_t i=0; i<args.nops(); i++) {
+                if (not is_exactly_a<symbol>(args.op(i)))
+                        throw std::invalid_argument("compiled_ex: argument is not a symbol");
+                if (not regs.emplace(args.op(i), i).second)
+                        throw std::invalid_argument("compiled_ex: repeated argument");
+        }
+}
+
+unsigned bytecode_compiler::emit(compiled_ex::opcode op, unsigned a,
+                                 unsigned b, long n)
+{
+        compiled_ex::instruction in;
+        in.op = op;
+        in.dst = ce.num_regs++;
+        in.a = a;
+        in.b = b;
+        in.n = n;
+        ce.code.push_back(in);
+        return in.dst;
+}
+
+unsigned bytecode_compiler::compile(const ex& e)
+{
+        auto it = regs.find(e);
+        if (it != regs.end())
+                return it->second;
+        unsigned r = compile_new(e);
+        regs.emplace(e, r);
+        return r;
+}
+
+unsigned bytecode_compiler::compile_new(const ex& e)
+{
+        if (is_exactly_a<symbol>(e))
+                throw std::invalid_argument("compiled_ex: symbol "
+                                + ex_to<symbol>(e).get_name()
+                                + " is not an argument");
+        if (is_exactly_a<numeric>(e) or is_exactly_a<constant>(e)) {
+                ce.consts.push_back(e);
+                ce.const_regs.push_back(ce.num_regs);
+                return ce.num_regs++;
+        }
+        if (is_exactly_a<add>(e) or is_exactly_a<mul>(e)) {
+                auto op = is_exactly_a<add>(e) ? compiled_ex::op_add
+                                               : compiled_ex::op_mul;
+                unsigned r = compile(e.op(0));
+                for (size_t i=1; i<e.nops(); i++)
+                        r = emit(op, r, compile(e.op(i)));
+                return r;
+        }
+        if (is_exactly_a<power>(e)) {
+                const ex& expo = e.op(1);
+                unsigned base = compile(e.op(0));
+                if (is_exactly_a<numeric>(expo)
+                    and ex_to<numeric>(expo).is_long())
+                        return emit(compiled_ex::op_powi, base, 0,
+                                    ex_to<numeric>(expo).to_long());
+                if (expo.is_equal(_ex1_2))
+                        return emit(compiled_ex::op_sqrt, base);
+                if (expo.is_equal(_ex_1_2))
+                        return emit(compiled_ex::op_powi,
+                                    emit(compiled_ex::op_sqrt, base), 0, -1);
+                return emit(compiled_ex::op_pow, base, compile(expo));
+        }
+        if (is_exactly_a<function>(e)) {
+                const function& f = ex_to<function>(e);
+                unsigned serial = f.get_serial();
+                if (serial == atan2_SERIAL::serial) {
+                        ce.has_cdouble = false;
+                        return emit(compiled_ex::op_atan2, compile(f.op(0)),
+                                    compile(f.op(1)));
+                }
+                auto search = funcmap().find(serial);
+                if (f.nops() != 1 or search == funcmap().end())
+                        throw std::domain_error("compiled_ex: function "
+                                        + f.get_name()
+                                        + " has no native kernel");
+                auto kit = kernel_index.find(serial);
+                if (kit == kernel_index.end()) {
+                        compiled_ex::kernel k;
+                        k.d = double_kernel(serial);
+                        k.c = cdouble_kernel(serial);
+                        k.m = search->second;
+                        if (k.d == nullptr)
+                                ce.has_double = false;
+                        if (k.c == nullptr)
+                                ce.has_cdouble = false;
+                        ce.kernels.push_back(k);
+                        kit = kernel_index.emplace(serial,
+                                        ce.kernels.size() - 1).first;
+                }
+                return emit(compiled_ex::op_call, compile(f.op(0)), 0,
+                            kit->second);
+        }
+        throw std::domain_error("compiled_ex: expression not handled");
+}
+
+compiled_ex::compiled_ex(const ex& e, const lst& args)
+  : num_args(args.nops()), num_regs(args.nops())
+{
+        bytecode_compiler bc(*this, args);
+        result = bc.compile(e);
+        for (const auto& c : consts) {
+                dconsts.push_back(c.evalf_double());
+                cconsts.push_back(c.evalf_cdouble());
+        }
+}
+
+// the kernel for the type of x
+static inline double call(double_kernel_t d, cdouble_kernel_t c, double x)
+{
+        return d(x);
+}
+
+static inline cdouble call(double_kernel_t d, cdouble_kernel_t c, cdouble x)
+{
+        return c(x);
+}
+
+static inline double powi(double x, long n)
+{
+        return std::pow(x, static_cast<double>(n));
+}
+
+static inline cdouble powi(cdouble z, long n)
+{
+        return cdouble_int_power(z, n);
+}
+
+static inline double arctan2(double y, double x)
+{
+        return std::atan2(y, x);
+}
+
+// not reached, compiled_ex::has_cdouble is false with atan2()
+static inline cdouble arctan2(cdouble y, cdouble x)
+{
+        throw std::domain_error("compiled_ex: atan2() of complex numbers");
+}
+
+template <typename T>
+void compiled_ex::run(T* r) const
+{
+        for (const auto& in : code) {
+                switch (in.op) {
+                case op_add:
+                        r[in.dst] = r[in.a] + r[in.b];
+                        break;
+                case op_mul:
+                        r[in.dst] = r[in.a] * r[in.b];
+                        break;
+                case op_powi:
+                        r[in.dst] = powi(r[in.a], in.n);
+                        break;
+                case op_sqrt:
+                        r[in.dst] = std::sqrt(r[in.a]);
+                        break;
+                case op_pow:
+                        r[in.dst] = std::pow(r[in.a], r[in.b]);
+                        break;
+                case op_atan2:
+                        r[in.dst] = arctan2(r[in.a], r[in.b]);
+                        break;
+                case op_call:
+                        r[in.dst] = call(kernels[in.n].d, kernels[in.n].c,
+                                         r[in.a]);
+                        break;
+                }
+        }
+}
+
+double compiled_ex::eval(const double* x) const
+{
+        if (not has_double)
+                throw std::domain_error("compiled_ex::eval(): function without double kernel");
+        std::vector<double> r(num_regs);
+        std::copy(x, x + num_args, r.begin());
+        for (size_t i=0; i<consts.size(); i++)
+                r[const_regs[i]] = dconsts[i];
+        run(r.data());
+        return r[result];
+}
+
+std::complex<double> compiled_ex::eval(const std::complex<double>* x) const
+{
+        if (not has_cdouble)
+                throw std::domain_error("compiled_ex::eval(): function without complex kernel");
+        std::vector<cdouble> r(num_regs);
+        std::copy(x, x + num_args, r.begin());
+        for (size_t i=0; i<consts.size(); i++)
+                r[const_regs[i]] = cconsts[i];
+        run(r.data());
+        return r[result];
+}
+
+// In batch evaluation every register holds a block of this many points,
+// and every instruction is a loop over the lanes of a block that the
+// compiler can vectorize.
+static const size_t block_size = 256;
+
+// d = a**n for all lanes by repeated squaring, with the same sequence of
+// operations in every lane; t is a scratch block
+static void powi_block(double* d, const double* a, long n, double* t,
+                       size_t lanes)
+{
+        unsigned long e = n < 0 ? -static_cast<unsigned long>(n) : n;
+        std::copy(a, a + lanes, t);
+        std::fill(d, d + lanes, 1.);
+        while (true) {
+                if ((e & 1) != 0)
+                        for (size_t l=0; l<lanes; l++)
+                                d[l] *= t[l];
+                e >>= 1;
+                if (e == 0)
+                        break;
+                for (size_t l=0; l<lanes; l++)
+                        t[l] *= t[l];
+        }
+        if (n < 0)
+                for (size_t l=0; l<lanes; l++)
+                        d[l] = 1 / d[l];
+}
+
+// Register i starts at r + i*block_size, the scratch block follows the
+// last register.
+void compiled_ex::run_block(double* r, size_t lanes) const
+{
+        double* scratch = r + num_regs * block_size;
+        for (const auto& in : code) {
+                double* d = r + in.dst * block_size;
+                const double* a = r + in.a * block_size;
+                const double* b = r + in.b * block_size;
+                switch (in.op) {
+                case op_add:
+                        for (size_t l=0; l<lanes; l++)
+                                d[l] = a[l] + b[l];
+                        break;
+                case op_mul:
+                        for (size_t l=0; l<lanes; l++)
+                                d[l] = a[l] * b[l];
+                        break;
+                case op_powi:
+                        powi_block(d, a, in.n, scratch, lanes);
+                        break;
+                case op_sqrt:
+                        for (size_t l=0; l<lanes; l++)
+                                d[l] = std::sqrt(a[l]);
+                        break;
+                case op_pow:
+                        for (size_t l=0; l<lanes; l++)
+                                d[l] = std::pow(a[l], b[l]);
+                        break;
+                case op_atan2:
+                        for (size_t l=0; l<lanes; l++)
+                                d[l] = std::atan2(a[l], b[l]);
+                        break;
+                case op_call: {
+                        double_kernel_t f = kernels[in.n].d;
+                        for (size_t l=0; l<lanes; l++)
+                                d[l] = f(a[l]);
+                        break;
+                }
+                }
+        }
+}
+
+void compiled_ex::eval(double* out, const double* const* x, size_t n) const
+{
+        if (not has_double)
+                throw std::domain_error("compiled_ex::eval(): function without double kernel");
+        const size_t nblocks = (n + block_size - 1) / block_size;
+        const size_t ntasks = std::min<size_t>(parallel_threads(), nblocks);
+        parallel_for(ntasks, [&](size_t task) {
+                std::vector<double> r((num_regs + 1) * block_size);
+                for (size_t i=0; i<consts.size(); i++)
+                        std::fill_n(r.begin() + const_regs[i] * block_size,
+                                    block_size, dconsts[i]);
+                for (size_t blk = nblocks * task / ntasks;
+                     blk < nblocks * (task + 1) / ntasks; blk++) {
+                        const size_t start = blk * block_size;
+                        const size_t lanes = std::min(block_size, n - start);
+                        for (size_t j=0; j<num_args; j++)
+                                std::copy(x[j] + start, x[j] + start + lanes,
+                                          r.begin() + j * block_size);
+                        run_block(r.data(), lanes);
+                        std::copy(r.begin() + result * block_size,
+                                  r.begin() + result * block_size + lanes,
+                                  out + start);
+                }
+        });
+}
+
+/** Registers of MPFR floats of a common precision. */
+class mpfr_registers {
+public:
+        mpfr_registers(size_t n, mpfr_prec_t prec) : regs(n)
+        {
+                for (auto& m : regs)
+                        mpfr_init2(&m, prec);
+        }
+        ~mpfr_registers()
+        {
+                for (auto& m : regs)
+                        mpfr_clear(&m);
+        }
+        mpfr_registers(const mpfr_registers&) = delete;
+        mpfr_registers& operator=(const mpfr_registers&) = delete;
+        mpfr_ptr operator[](size_t i) { return &regs[i]; }
+private:
+        std::vector<__mpfr_struct> regs;
+};
+
+// Exact numbers and MPFR floats are rounded to the precision of r, other
+// real numbers come from their double value.
+static void mpfr_set_constant(mpfr_ptr r, const ex& c)
+{
+        if (is_exactly_a<constant>(c)) {
+                unsigned serial = ex_to<constant>(c).get_serial();
+                if (serial == Pi.get_serial())
+                        mpfr_const_pi(r, MPFR_RNDN);
+                else if (serial == Euler.get_serial())
+                        mpfr_const_euler(r, MPFR_RNDN);
+                else if (serial == Catalan.get_serial())
+                        mpfr_const_catalan(r, MPFR_RNDN);
+                else
+                        mpfr_set_d(r, c.evalf_double(), MPFR_RNDN);
+                return;
+        }
+        const numeric& num = ex_to<numeric>(c);
+        if (num.is_long())
+                mpfr_set_si(r, num.to_long(), MPFR_RNDN);
+        else if (num.is_mpz())
+                mpfr_set_z(r, num.as_mpz(), MPFR_RNDN);
+        else if (num.is_mpq())
+                mpfr_set_q(r, num.as_mpq(), MPFR_RNDN);
+        else if (num.is_mpfr())
+                mpfr_set(r, num.as_mpfr(), MPFR_RNDN);
+        else if (num.is_real())
+                mpfr_set_d(r, num.to_double(), MPFR_RNDN);
+        else
+                throw std::domain_error("compiled_ex::eval(): complex constant");
+}
+
+void compiled_ex::eval(mpfr_ptr res, const mpfr_srcptr* x) const
+{
+        mpfr_registers r(num_regs, mpfr_get_prec(res));
+        for (size_t i=0; i<num_args; i++)
+                mpfr_set(r[i], x[i], MPFR_RNDN);
+        for (size_t i=0; i<consts.size(); i++)
+                mpfr_set_constant(r[const_regs[i]], consts[i]);
+        for (const auto& in : code) {
+                switch (in.op) {
+                case op_add:
+                        mpfr_add(r[in.dst], r[in.a], r[in.b], MPFR_RNDN);
+                        break;
+                case op_mul:
+                        mpfr_mul(r[in.dst], r[in.a], r[in.b], MPFR_RNDN);
+                        break;
+                case op_powi:
+                        mpfr_pow_si(r[in.dst], r[in.a], in.n, MPFR_RNDN);
+                        break;
+                case op_sqrt:
+                        mpfr_sqrt(r[in.dst], r[in.a], MPFR_RNDN);
+                        break;
+                case op_pow:
+                        mpfr_pow(r[in.dst], r[in.a], r[in.b], MPFR_RNDN);
+                        break;
+                case op_atan2:
+                        mpfr_atan2(r[in.dst], r[in.a], r[in.b], MPFR_RNDN);
+                        break;
+                case op_call:
+                        kernels[in.n].m(r[in.dst], r[in.a], MPFR_RNDN);
+                        break;
+                }
+        }
+        mpfr_set(res, r[result], MPFR_RNDN);
+}
+
+} // namespace GiNaC
@@ -0,0 +1,106 @@
+/** @file compiled_ex.h
+ *
+ *  Interface to expressions compiled into bytecode for repeated numeric
+ *  evaluation. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_COMPILED_EX_H__
+#define __PYNAC_COMPILED_EX_H__
+
+#include "ex.h"
+#include "lst.h"
+
+#include <mpfr.h>
+#include <complex>
+#include <vector>
+
+namespace GiNaC {
+
+/** An expression in the symbols args, lowered to straight-line code for a
+ *  register machine.  Equal subexpressions are computed once.  The code
+ *  can be run on doubles, complex doubles and MPFR floats, with functions
+ *  computed by the C++ library and MPFR.  Out of their real domain,
+ *  functions give NaN in doubles and MPFR floats.
+ *
+ *  The expression may contain the symbols in args, numbers, constants,
+ *  sums, products, powers, atan2() and the functions of one argument that
+ *  have a native kernel: the elementary functions and their inverses,
+ *  abs, gamma, lgamma, factorial, and, in MPFR only, psi, zeta and Li2. */
+class compiled_ex {
+public:
+        /** @exception invalid_argument (e contains other symbols)
+         *  @exception domain_error (e contains other kinds of objects) */
+        compiled_ex(const ex& e, const lst& args);
+
+        /** The number of arguments of eval(). */
+        size_t nargs() const { return num_args; }
+        /** The number of instructions. */
+        size_t size() const { return code.size(); }
+
+        /** Evaluate at the point x, which has nargs() entries.
+         *  @exception domain_error (a function has no kernel for the type) */
+        double eval(const double* x) const;
+        std::complex<double> eval(const std::complex<double>* x) const;
+        /** Evaluate at the point x, at the precision of r. */
+        void eval(mpfr_ptr r, const mpfr_srcptr* x) const;
+        /** Evaluate in doubles at n points, given by the columns x[0], ...,
+         *  x[nargs()-1] of length n, and write the values to out.  Blocks of
+         *  points are evaluated in parallel (@see set_parallel_threads()). */
+        void eval(double* out, const double* const* x, size_t n) const;
+
+private:
+        enum opcode : unsigned char {
+                op_add,         // r[dst] = r[a] + r[b]
+                op_mul,         // r[dst] = r[a] * r[b]
+                op_powi,        // r[dst] = r[a] ** n
+                op_sqrt,        // r[dst] = sqrt(r[a])
+                op_pow,         // r[dst] = r[a] ** r[b]
+                op_atan2,       // r[dst] = atan2(r[a], r[b])
+                op_call,        // r[dst] = kernels[n](r[a])
+        };
+        struct instruction {
+                opcode op;
+                unsigned dst, a, b;
+                long n;
+        };
+        struct kernel {
+                double (*d)(double);
+                std::complex<double> (*c)(std::complex<double>);
+                int (*m)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t);
+        };
+        friend class bytecode_compiler;
+
+        template <typename T> void run(T* r) const;
+        void run_block(double* r, size_t lanes) const;
+
+        // the first registers hold the arguments
+        size_t num_args, num_regs;
+        unsigned result;
+        std::vector<instruction> code;
+        std::vector<kernel> kernels;
+        // constants and the registers they are loaded into
+        exvector consts;
+        std::vector<unsigned> const_regs;
+        std::vector<double> dconsts;
+        std::vector<std::complex<double>> cconsts;
+        bool has_double = true, has_cdouble = true;
+};
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_COMPILED_EX_H__
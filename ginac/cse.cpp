@@ -0,0 +1,133 @@
+/** @file cse.cpp
+ *
+ *  Implementation of common subexpression elimination. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cse.h"
+#include "ex.h"
+#include "lst.h"
+#include "symbol.h"
+#include "relational.h"
+#include "operators.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace GiNaC {
+
+using count_map = std::unordered_map<ex, size_t, ex_hash, ex_is_equal>;
+
+// Count the occurrences of the subexpressions of e that are not atoms.
+// The children of a subexpression are only visited at its first
+// occurrence, so the work is linear in the size of the DAG.  An explicit
+// stack is used as expressions can be very deep.
+static void count_subexpressions(const ex & e, count_map & counts)
+{
+        std::vector<ex> stack;
+        stack.push_back(e);
+        while (not stack.empty()) {
+                ex x = stack.back();
+                stack.pop_back();
+                if (x.nops() == 0)
+                        continue;
+                auto res = counts.emplace(x, 1);
+                if (not res.second) {
+                        ++res.first->second;
+                        continue;
+                }
+                for (size_t i=0; i<x.nops(); i++)
+                        stack.push_back(x.op(i));
+        }
+}
+
+// Rebuild an expression bottom-up, replacing each subexpression that
+// occurs more than once by a new symbol.  Like the counting, this works
+// from an explicit stack: a node is rebuilt by map() once all of its
+// children are in done, so map() only looks them up and never recurses.
+class cse_replacer : public map_function {
+public:
+        cse_replacer(const count_map & c, lst & t) : counts(c), temps(t) {}
+
+        ex operator()(const ex & e) override
+        {
+                auto search = done.find(e);
+                if (search == done.end())
+                        return e;
+                return search->second;
+        }
+
+        ex reduce(const ex & e)
+        {
+                // nodes, and whether their children have been pushed
+                std::vector<std::pair<ex, bool>> stack;
+                stack.emplace_back(e, false);
+                while (not stack.empty()) {
+                        ex x = stack.back().first;
+                        if (x.nops() == 0 or done.find(x) != done.end()) {
+                                stack.pop_back();
+                                continue;
+                        }
+                        if (not stack.back().second) {
+                                stack.back().second = true;
+                                for (size_t i=0; i<x.nops(); i++)
+                                        stack.emplace_back(x.op(i), false);
+                                continue;
+                        }
+                        stack.pop_back();
+                        ex reduced = x.map(*this);
+                        auto c = counts.find(x);
+                        if (c != counts.end() and c->second > 1) {
+                                symbol* sp = new symbol;
+                                sp->set_domain_from_ex(reduced);
+                                ex es = sp->setflag(status_flags::dynallocated);
+                                temps.append(es == reduced);
+                                reduced = es;
+                        }
+                        done.emplace(x, reduced);
+                }
+                return (*this)(e);
+        }
+
+private:
+        const count_map & counts;
+        lst & temps;
+        std::unordered_map<ex, ex, ex_hash, ex_is_equal> done;
+};
+
+ex cse(const ex & e, lst & temps)
+{
+        count_map counts;
+        count_subexpressions(e, counts);
+        cse_replacer replace(counts, temps);
+        return replace.reduce(e);
+}
+
+exvector cse(const exvector & v, lst & temps)
+{
+        count_map counts;
+        for (const auto & e : v)
+                count_subexpressions(e, counts);
+        cse_replacer replace(counts, temps);
+        exvector result;
+        result.reserve(v.size());
+        for (const auto & e : v)
+                result.push_back(replace.reduce(e));
+        return result;
+}
+
+} // namespace GiNaC
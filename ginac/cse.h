@@ -0,0 +1,45 @@
+/** @file cse.h
+ *
+ *  Interface to common subexpression elimination. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_CSE_H__
+#define __PYNAC_CSE_H__
+
+#include "ex.h"
+#include "lst.h"
+
+namespace GiNaC {
+
+/** Common subexpression elimination.  Every subexpression that occurs more
+ *  than once in e, and is not a symbol, number or constant, is replaced by
+ *  a new symbol.  The equations symbol == subexpression are appended to
+ *  temps in an order in which each right-hand side only contains symbols
+ *  defined before it.  Returns the reduced expression.
+ *
+ *  Subexpressions are found by gethash() and is_equal(), in time linear in
+ *  the number of nodes apart from hash collisions. */
+ex cse(const ex & e, lst & temps);
+
+/** Common subexpression elimination on several expressions, which share
+ *  the temporaries. */
+exvector cse(const exvector & v, lst & temps);
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_CSE_H__
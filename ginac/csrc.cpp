@@ -0,0 +1,774 @@
+/** @file csrc.cpp
+ *
+ *  Output of expressions as C functions. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "csrc.h"
+#include "numeric.h"
+#include "add.h"
+#include "mul.h"
+#include "power.h"
+#include "symbol.h"
+#include "constant.h"
+#include "function.h"
+#include "inifcns.h"
+#include "operators.h"
+#include "utils.h"
+
+#include <mpfr.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <locale>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace GiNaC {
+
+// C code for the functions in doubles, % stands for the argument
+static const std::unordered_map<unsigned int,const char*>& double_funcmap()
+{
+        static std::unordered_map<unsigned int,const char*> _funcmap = {{
+                {exp_SERIAL::serial, "exp(%)"},
+                {log_SERIAL::serial, "log(%)"},
+                {sin_SERIAL::serial, "sin(%)"},
+                {cos_SERIAL::serial, "cos(%)"},
+                {tan_SERIAL::serial, "tan(%)"},
+                {cot_SERIAL::serial, "1/tan(%)"},
+                {sec_SERIAL::serial, "1/cos(%)"},
+                {csc_SERIAL::serial, "1/sin(%)"},
+                {asin_SERIAL::serial, "asin(%)"},
+                {acos_SERIAL::serial, "acos(%)"},
+                {atan_SERIAL::serial, "atan(%)"},
+                {acot_SERIAL::serial, "atan(1/%)"},
+                {asec_SERIAL::serial, "acos(1/%)"},
+                {acsc_SERIAL::serial, "asin(1/%)"},
+                {sinh_SERIAL::serial, "sinh(%)"},
+                {cosh_SERIAL::serial, "cosh(%)"},
+                {tanh_SERIAL::serial, "tanh(%)"},
+                {coth_SERIAL::serial, "1/tanh(%)"},
+                {sech_SERIAL::serial, "1/cosh(%)"},
+                {csch_SERIAL::serial, "1/sinh(%)"},
+                {asinh_SERIAL::serial, "asinh(%)"},
+                {acosh_SERIAL::serial, "acosh(%)"},
+                {atanh_SERIAL::serial, "atanh(%)"},
+                {acoth_SERIAL::serial, "atanh(1/%)"},
+                {asech_SERIAL::serial, "acosh(1/%)"},
+                {acsch_SERIAL::serial, "asinh(1/%)"},
+                {abs_SERIAL::serial, "fabs(%)"},
+                {gamma_SERIAL::serial, "tgamma(%)"},
+                {lgamma_SERIAL::serial, "lgamma(%)"},
+                {factorial_SERIAL::serial, "tgamma(% + 1)"},
+        }};
+
+        return _funcmap;
+}
+
+// MPFR functions, applied to 1/x for the inverse reciprocal functions
+// and to x+1 for factorial
+struct mpfr_function {
+        const char* name;
+        enum { direct, inverse, shifted } arg;
+};
+
+static const std::unordered_map<unsigned int,mpfr_function>& mpfr_funcmap()
+{
+        static std::unordered_map<unsigned int,mpfr_function> _funcmap = {{
+                {exp_SERIAL::serial, {"mpfr_exp", mpfr_function::direct}},
+                {log_SERIAL::serial, {"mpfr_log", mpfr_function::direct}},
+                {sin_SERIAL::serial, {"mpfr_sin", mpfr_function::direct}},
+                {cos_SERIAL::serial, {"mpfr_cos", mpfr_function::direct}},
+                {tan_SERIAL::serial, {"mpfr_tan", mpfr_function::direct}},
+                {cot_SERIAL::serial, {"mpfr_cot", mpfr_function::direct}},
+                {sec_SERIAL::serial, {"mpfr_sec", mpfr_function::direct}},
+                {csc_SERIAL::serial, {"mpfr_csc", mpfr_function::direct}},
+                {asin_SERIAL::serial, {"mpfr_asin", mpfr_function::direct}},
+                {acos_SERIAL::serial, {"mpfr_acos", mpfr_function::direct}},
+                {atan_SERIAL::serial, {"mpfr_atan", mpfr_function::direct}},
+                {acot_SERIAL::serial, {"mpfr_atan", mpfr_function::inverse}},
+                {asec_SERIAL::serial, {"mpfr_acos", mpfr_function::inverse}},
+                {acsc_SERIAL::serial, {"mpfr_asin", mpfr_function::inverse}},
+                {sinh_SERIAL::serial, {"mpfr_sinh", mpfr_function::direct}},
+                {cosh_SERIAL::serial, {"mpfr_cosh", mpfr_function::direct}},
+                {tanh_SERIAL::serial, {"mpfr_tanh", mpfr_function::direct}},
+                {coth_SERIAL::serial, {"mpfr_coth", mpfr_function::direct}},
+                {sech_SERIAL::serial, {"mpfr_sech", mpfr_function::direct}},
+                {csch_SERIAL::serial, {"mpfr_csch", mpfr_function::direct}},
+                {asinh_SERIAL::serial, {"mpfr_asinh", mpfr_function::direct}},
+                {acosh_SERIAL::serial, {"mpfr_acosh", mpfr_function::direct}},
+                {atanh_SERIAL::serial, {"mpfr_atanh", mpfr_function::direct}},
+                {acoth_SERIAL::serial, {"mpfr_atanh", mpfr_function::inverse}},
+                {asech_SERIAL::serial, {"mpfr_acosh", mpfr_function::inverse}},
+                {acsch_SERIAL::serial, {"mpfr_asinh", mpfr_function::inverse}},
+                {abs_SERIAL::serial, {"mpfr_abs", mpfr_function::direct}},
+                {gamma_SERIAL::serial, {"mpfr_gamma", mpfr_function::direct}},
+                {lgamma_SERIAL::serial, {"mpfr_lngamma", mpfr_function::direct}},
+                {factorial_SERIAL::serial, {"mpfr_gamma", mpfr_function::shifted}},
+                {psi1_SERIAL::serial, {"mpfr_digamma", mpfr_function::direct}},
+                {zeta1_SERIAL::serial, {"mpfr_zeta", mpfr_function::direct}},
+                {Li2_SERIAL::serial, {"mpfr_li2", mpfr_function::direct}},
+        }};
+
+        return _funcmap;
+}
+
+// The degree of the term t in x, or -1 if t is not a monomial in x
+// times a factor free of x.
+static long monomial_degree(const ex & t, const ex & x)
+{
+        if (t.is_equal(x))
+                return 1;
+        if (is_exactly_a<power>(t) and t.op(0).is_equal(x)) {
+                const ex & expo = t.op(1);
+                if (is_exactly_a<numeric>(expo)
+                    and ex_to<numeric>(expo).is_pos_integer()
+                    and ex_to<numeric>(expo).is_long())
+                        return ex_to<numeric>(expo).to_long();
+                return -1;
+        }
+        if (is_exactly_a<mul>(t)) {
+                long deg = 0;
+                for (size_t i=0; i<t.nops(); i++) {
+                        long k = monomial_degree(t.op(i), x);
+                        if (k < 0)
+                                return -1;
+                        deg += k;
+                }
+                return deg;
+        }
+        return t.has(x) ? -1 : 0;
+}
+
+// The factor of the monomial t that is free of x.
+static ex monomial_coeff(const ex & t, const ex & x)
+{
+        if (t.is_equal(x) or is_exactly_a<power>(t))
+                return t.has(x) ? _ex1 : t;
+        if (not is_exactly_a<mul>(t))
+                return t;
+        exvector factors;
+        factors.reserve(t.nops());
+        for (size_t i=0; i<t.nops(); i++)
+                if (not t.op(i).has(x))
+                        factors.push_back(t.op(i));
+        return mul(factors);
+}
+
+// Rewrite the sums that are polynomials of degree at least two in one
+// of the arguments in Horner form.  The variable of highest degree is
+// taken out first, and gaps in the degrees become powers.
+struct horner_form : public map_function {
+        const exvector & vars;
+        std::unordered_map<ex, ex, ex_hash, ex_is_equal> done;
+
+        horner_form(const exvector & v) : vars(v) {}
+
+        ex operator()(const ex & e) override
+        {
+                if (e.nops() == 0)
+                        return e;
+                auto search = done.find(e);
+                if (search != done.end())
+                        return search->second;
+
+                ex result = e.map(*this);
+                if (is_exactly_a<add>(result))
+                        result = horner(result);
+                done.emplace(e, result);
+                return result;
+        }
+
+        ex horner(const ex & a)
+        {
+                ex x;
+                long degree = 1;
+                for (const auto & v : vars) {
+                        long deg = 0;
+                        for (size_t i=0; i<a.nops(); i++) {
+                                long k = monomial_degree(a.op(i), v);
+                                if (k < 0) {
+                                        deg = -1;
+                                        break;
+                                }
+                                deg = std::max(deg, k);
+                        }
+                        if (deg > degree) {
+                                x = v;
+                                degree = deg;
+                        }
+                }
+                if (degree < 2)
+                        return a;
+
+                std::map<long, exvector, std::greater<long>> coeffs;
+                for (size_t i=0; i<a.nops(); i++)
+                        coeffs[monomial_degree(a.op(i), x)].push_back(
+                                        monomial_coeff(a.op(i), x));
+                ex result;
+                long prev = -1;
+                for (const auto & p : coeffs) {
+                        ex c = add(p.second);
+                        if (is_exactly_a<add>(c))
+                                c = horner(c);
+                        if (prev < 0)
+                                result = c;
+                        else
+                                result = result * pow(x, prev - p.first) + c;
+                        prev = p.first;
+                }
+                if (prev > 0)
+                        result = result * pow(x, prev);
+                return result;
+        }
+};
+
+// A C constant with the double value d, in parentheses if negative.
+static std::string double_literal(double d)
+{
+        if (std::isnan(d))
+                return "NAN";
+        if (std::isinf(d))
+                return d > 0 ? "INFINITY" : "(-INFINITY)";
+        std::ostringstream os;
+        os.imbue(std::locale::classic());
+        os << std::setprecision(17) << d;
+        std::string s = os.str();
+        if (s.find_first_of(".e") == std::string::npos)
+                s += ".0";
+        if (d < 0)
+                return "(" + s + ")";
+        return s;
+}
+
+/** Lowers an expression into straight-line C code.  Every distinct
+ *  subexpression gets its own variable, _tN for doubles and _t[N] for
+ *  MPFR floats.  Operands are variables, or constants with doubles. */
+class csrc_generator {
+public:
+        csrc_generator(const print_csrc & c, const lst & args);
+        void print_function(const std::string & name, const ex & e);
+private:
+        std::string lower(const ex & e);
+        std::string lower_new(const ex & e);
+        std::string lower_numeric(const numeric & num);
+        std::string lower_constant(const constant & c);
+        std::string lower_add(const ex & e);
+        std::string lower_mul(const ex & e);
+        std::string lower_power(const ex & e);
+        std::string lower_function(const function & f);
+        std::string product(const std::vector<std::string> & factors);
+        std::string integer_power(const std::string & a, long n);
+        std::string powi(const std::string & a, unsigned long n);
+        std::string binary(char op, const std::string & a, const std::string & b);
+        std::string call(const char* fmt, const char* mpfr_name,
+                         const std::string & a);
+        std::string assign(const std::string & rhs);
+        std::string new_register();
+        void emit(const std::string & fn, const std::string & r,
+                  const std::string & a);
+        void emit(const std::string & fn, const std::string & r,
+                  const std::string & a, const std::string & b);
+
+        const print_csrc & ctx;
+        const bool mpfr;
+        exvector params;
+        std::ostringstream body;
+        unsigned num_regs = 0;
+        std::unordered_map<ex, std::string, ex_hash, ex_is_equal> values;
+        std::map<std::pair<std::string, unsigned long>, std::string> powers;
+};
+
+static bool is_c_identifier(const std::string & s)
+{
+        // names starting with _ are left to the generated code
+        if (s.empty() or not std::isalpha(s[0], std::locale::classic()))
+                return false;
+        for (char ch : s)
+                if (ch != '_' and not std::isalnum(ch, std::locale::classic()))
+                        return false;
+        return true;
+}
+
+// The name of the function called by a C code template such as "1/tan(%)".
+static std::string template_function(const char* fmt)
+{
+        std::string s(fmt);
+        if (s.compare(0, 2, "1/") == 0)
+                s.erase(0, 2);
+        return s.substr(0, s.find('('));
+}
+
+// C keywords, and the names of the functions and macros that the
+// generated code uses, which an argument would shadow.
+static bool is_reserved(const std::string & s)
+{
+        static const std::set<std::string> reserved = [] {
+                std::set<std::string> r = {
+                        "auto", "break", "case", "char", "const", "continue",
+                        "default", "do", "double", "else", "enum", "extern",
+                        "float", "for", "goto", "if", "inline", "int", "long",
+                        "register", "restrict", "return", "short", "signed",
+                        "sizeof", "static", "struct", "switch", "typedef",
+                        "union", "unsigned", "void", "volatile", "while",
+                        "sqrt", "pow", "atan2", "NAN", "INFINITY",
+                };
+                for (const auto & p : double_funcmap())
+                        r.insert(template_function(p.second));
+                return r;
+        }();
+        return reserved.find(s) != reserved.end()
+                or s.compare(0, 5, "mpfr_") == 0
+                or s.compare(0, 5, "MPFR_") == 0;
+}
+
+csrc_generator::csrc_generator(const print_csrc & c, const lst & args)
+  : ctx(c), mpfr(c.type == print_csrc::ctype_mpfr)
+{
+        std::set<std::string> names;
+        for (size_t i=0; i<args.nops(); i++) {
+                const ex & x = args.op(i);
+                if (not is_exactly_a<symbol>(x))
+                        throw std::invalid_argument("print_csrc_function(): argument is not a symbol");
+                const std::string & name = ex_to<symbol>(x).get_name();
+                if (not is_c_identifier(name))
+                        throw std::invalid_argument("print_csrc_function(): argument "
+                                        + name + " is not a C identifier");
+                if (is_reserved(name))
+                        throw std::invalid_argument("print_csrc_function(): argument "
+                                        + name + " is a reserved name");
+                if (not values.emplace(x, name).second
+                    or not names.insert(name).second)
+                        throw std::invalid_argument("print_csrc_function(): repeated argument");
+                params.push_back(x);
+        }
+}
+
+std::string csrc_generator::new_register()
+{
+        std::ostringstream os;
+        if (mpfr)
+                os << "_t[" << num_regs++ << "]";
+        else
+                os << "_t" << num_regs++;
+        return os.str();
+}
+
+// a new double variable with the value rhs
+std::string csrc_generator::assign(const std::string & rhs)
+{
+        std::string r = new_register();
+        body << "        const double " << r << " = " << rhs << ";\n";
+        return r;
+}
+
+void csrc_generator::emit(const std::string & fn, const std::string & r,
+                          const std::string & a)
+{
+        body << "        " << fn << "(" << r << ", " << a << ", _rnd);\n";
+}
+
+void csrc_generator::emit(const std::string & fn, const std::string & r,
+                          const std::string & a, const std::string & b)
+{
+        body << "        " << fn << "(" << r << ", " << a << ", " << b
+             << ", _rnd);\n";
+}
+
+std::string csrc_generator::binary(char op, const std::string & a,
+                                   const std::string & b)
+{
+        if (not mpfr)
+                return assign(a + " " + op + " " + b);
+        std::string r = new_register();
+        switch (op) {
+        case '+':
+                emit("mpfr_add", r, a, b);
+                break;
+        case '-':
+                emit("mpfr_sub", r, a, b);
+                break;
+        case '*':
+                if (a == b)
+                        emit("mpfr_sqr", r, a);
+                else
+                        emit("mpfr_mul", r, a, b);
+                break;
+        case '/':
+                emit("mpfr_div", r, a, b);
+                break;
+        }
+        return r;
+}
+
+// fmt is the C code with doubles, % standing for a
+std::string csrc_generator::call(const char* fmt, const char* mpfr_name,
+                                 const std::string & a)
+{
+        if (mpfr) {
+                std::string r = new_register();
+                emit(mpfr_name, r, a);
+                return r;
+        }
+        std::string rhs;
+        for (const char* p = fmt; *p != '\0'; p++)
+                if (*p == '%')
+                        rhs += a;
+                else
+                        rhs += *p;
+        return assign(rhs);
+}
+
+// a to the power n > 0 by repeated squaring, sharing the powers of a
+std::string csrc_generator::powi(const std::string & a, unsigned long n)
+{
+        if (n == 1)
+                return a;
+        auto key = std::make_pair(a, n);
+        auto search = powers.find(key);
+        if (search != powers.end())
+                return search->second;
+        std::string r;
+        if (n % 2 == 0) {
+                std::string h = powi(a, n / 2);
+                r = binary('*', h, h);
+        }
+        else
+                r = binary('*', powi(a, n - 1), a);
+        powers.emplace(key, r);
+        return r;
+}
+
+std::string csrc_generator::integer_power(const std::string & a, long n)
+{
+        if (n == 0)
+                return mpfr ? lower(_ex1) : "1.0";
+        if (n > 0)
+                return powi(a, n);
+        std::string p = powi(a, -static_cast<unsigned long>(n));
+        if (not mpfr)
+                return assign("1/" + p);
+        std::string r = new_register();
+        body << "        mpfr_ui_div(" << r << ", 1, " << p << ", _rnd);\n";
+        return r;
+}
+
+// the product of factors, which is not empty
+std::string csrc_generator::product(const std::vector<std::string> & factors)
+{
+        if (factors.size() == 1)
+                return factors[0];
+        if (not mpfr) {
+                std::string rhs = factors[0];
+                for (size_t i=1; i<factors.size(); i++)
+                        rhs += "*" + factors[i];
+                return assign(rhs);
+        }
+        std::string r = new_register();
+        emit("mpfr_mul", r, factors[0], factors[1]);
+        for (size_t i=2; i<factors.size(); i++)
+                emit("mpfr_mul", r, r, factors[i]);
+        return r;
+}
+
+std::string csrc_generator::lower(const ex & e)
+{
+        auto search = values.find(e);
+        if (search != values.end())
+                return search->second;
+        std::string r = lower_new(e);
+        values.emplace(e, r);
+        return r;
+}
+
+std::string csrc_generator::lower_new(const ex & e)
+{
+        if (is_exactly_a<symbol>(e))
+                throw std::invalid_argument("print_csrc_function(): symbol "
+                                + ex_to<symbol>(e).get_name()
+                                + " is not an argument");
+        if (is_exactly_a<numeric>(e))
+                return lower_numeric(ex_to<numeric>(e));
+        if (is_exactly_a<constant>(e))
+                return lower_constant(ex_to<constant>(e));
+        if (is_exactly_a<add>(e))
+                return lower_add(e);
+        if (is_exactly_a<mul>(e))
+                return lower_mul(e);
+        if (is_exactly_a<power>(e))
+                return lower_power(e);
+        if (is_exactly_a<function>(e))
+                return lower_function(ex_to<function>(e));
+        throw std::domain_error("print_csrc_function(): expression not handled");
+}
+
+static std::string integer_digits(const numeric & num)
+{
+        std::ostringstream os;
+        os << num;
+        return os.str();
+}
+
+std::string csrc_generator::lower_numeric(const numeric & num)
+{
+        if (not num.is_real())
+                throw std::domain_error("print_csrc_function(): complex number");
+        if (not mpfr)
+                return double_literal(num.to_double());
+
+        std::string r = new_register();
+        if (num.is_long())
+                body << "        mpfr_set_si(" << r << ", " << num.to_long()
+                     << ", _rnd);\n";
+        else if (num.is_integer())
+                body << "        mpfr_set_str(" << r << ", \""
+                     << integer_digits(num) << "\", 10, _rnd);\n";
+        else if (num.is_rational())
+                emit("mpfr_div", r, lower(num.numer()), lower(num.denom()));
+        else if (num.is_mpfr()) {
+                // hexadecimal, which is exact
+                char* s;
+                mpfr_asprintf(&s, "%Ra", num.as_mpfr());
+                body << "        mpfr_set_str(" << r << ", \"" << s
+                     << "\", 0, _rnd);\n";
+                mpfr_free_str(s);
+        }
+        else
+                body << "        mpfr_set_d(" << r << ", "
+                     << double_literal(num.to_double()) << ", _rnd);\n";
+        return r;
+}
+
+std::string csrc_generator::lower_constant(const constant & c)
+{
+        unsigned serial = c.get_serial();
+        if (not mpfr)
+                return double_literal(ex(c).evalf_double());
+
+        std::string r = new_register();
+        if (serial == Pi.get_serial())
+                body << "        mpfr_const_pi(" << r << ", _rnd);\n";
+        else if (serial == Euler.get_serial())
+                body << "        mpfr_const_euler(" << r << ", _rnd);\n";
+        else if (serial == Catalan.get_serial())
+                body << "        mpfr_const_catalan(" << r << ", _rnd);\n";
+        else
+                body << "        mpfr_set_d(" << r << ", "
+                     << double_literal(ex(c).evalf_double()) << ", _rnd);\n";
+        return r;
+}
+
+// Terms with a negative coefficient are subtracted.
+std::string csrc_generator::lower_add(const ex & e)
+{
+        std::vector<std::pair<bool, std::string>> terms;
+        for (size_t i=0; i<e.nops(); i++) {
+                const ex & t = e.op(i);
+                bool negative = (is_exactly_a<numeric>(t)
+                                 and ex_to<numeric>(t).is_negative())
+                             or (is_exactly_a<mul>(t)
+                                 and ex_to<mul>(t).get_overall_coeff().is_negative());
+                terms.emplace_back(negative, lower(negative ? -t : t));
+        }
+        // start with a positive term if there is one
+        for (size_t i=1; i<terms.size(); i++)
+                if (terms[0].first and not terms[i].first) {
+                        std::swap(terms[0], terms[i]);
+                        break;
+                }
+
+        if (not mpfr) {
+                std::string rhs = (terms[0].first ? "-" : "") + terms[0].second;
+                for (size_t i=1; i<terms.size(); i++)
+                        rhs += (terms[i].first ? " - " : " + ") + terms[i].second;
+                return assign(rhs);
+        }
+        std::string r = new_register();
+        std::string acc = terms[0].second;
+        if (terms[0].first) {
+                emit("mpfr_neg", r, acc);
+                acc = r;
+        }
+        for (size_t i=1; i<terms.size(); i++) {
+                emit(terms[i].first ? "mpfr_sub" : "mpfr_add", r, acc,
+                     terms[i].second);
+                acc = r;
+        }
+        return r;
+}
+
+// Factors with a negative exponent go into the denominator.
+std::string csrc_generator::lower_mul(const ex & e)
+{
+        std::vector<std::string> numer, denom;
+        bool negate = false;
+        for (size_t i=0; i<e.nops(); i++) {
+                const ex & f = e.op(i);
+                if (is_exactly_a<numeric>(f) and f.is_equal(_ex_1))
+                        negate = true;
+                else if (is_exactly_a<power>(f)
+                         and is_exactly_a<numeric>(f.op(1))
+                         and ex_to<numeric>(f.op(1)).is_negative())
+                        denom.push_back(lower(pow(f.op(0), -f.op(1))));
+                else
+                        numer.push_back(lower(f));
+        }
+
+        std::string r;
+        if (not mpfr) {
+                std::string rhs = negate ? "-" : "";
+                rhs += numer.empty() ? "1" : numer[0];
+                for (size_t i=1; i<numer.size(); i++)
+                        rhs += "*" + numer[i];
+                if (denom.size() == 1)
+                        rhs += "/" + denom[0];
+                else if (not denom.empty()) {
+                        rhs += "/(" + denom[0];
+                        for (size_t i=1; i<denom.size(); i++)
+                                rhs += "*" + denom[i];
+                        rhs += ")";
+                }
+                return assign(rhs);
+        }
+        if (denom.empty())
+                r = product(numer);
+        else {
+                std::string d = product(denom);
+                r = new_register();
+                if (numer.empty())
+                        body << "        mpfr_ui_div(" << r << ", 1, " << d
+                             << ", _rnd);\n";
+                else
+                        emit("mpfr_div", r, product(numer), d);
+        }
+        if (negate) {
+                std::string n = new_register();
+                emit("mpfr_neg", n, r);
+                r = n;
+        }
+        return r;
+}
+
+std::string csrc_generator::lower_power(const ex & e)
+{
+        const ex & expo = e.op(1);
+        std::string base = lower(e.op(0));
+        if (is_exactly_a<numeric>(expo)) {
+                const numeric & n = ex_to<numeric>(expo);
+                if (n.is_long())
+                        return integer_power(base, n.to_long());
+                if (n.is_rational() and n.denom().is_equal(*_num2_p)
+                    and n.numer().is_long())
+                        return integer_power(call("sqrt(%)", "mpfr_sqrt", base),
+                                             n.numer().to_long());
+        }
+        std::string x = lower(expo);
+        if (mpfr) {
+                std::string r = new_register();
+                emit("mpfr_pow", r, base, x);
+                return r;
+        }
+        return assign("pow(" + base + ", " + x + ")");
+}
+
+std::string csrc_generator::lower_function(const function & f)
+{
+        unsigned serial = f.get_serial();
+        if (serial == atan2_SERIAL::serial) {
+                std::string y = lower(f.op(0)), x = lower(f.op(1));
+                if (not mpfr)
+                        return assign("atan2(" + y + ", " + x + ")");
+                std::string r = new_register();
+                emit("mpfr_atan2", r, y, x);
+                return r;
+        }
+        if (f.nops() == 1 and not mpfr) {
+                auto search = double_funcmap().find(serial);
+                if (search != double_funcmap().end())
+                        return call(search->second, nullptr, lower(f.op(0)));
+        }
+        if (f.nops() == 1 and mpfr) {
+                auto search = mpfr_funcmap().find(serial);
+                if (search != mpfr_funcmap().end()) {
+                        const mpfr_function & mf = search->second;
+                        std::string a = lower(f.op(0));
+                        std::string r = new_register();
+                        if (mf.arg == mpfr_function::inverse) {
+                                body << "        mpfr_ui_div(" << r << ", 1, "
+                                     << a << ", _rnd);\n";
+                                a = r;
+                        }
+                        else if (mf.arg == mpfr_function::shifted) {
+                                body << "        mpfr_add_ui(" << r << ", "
+                                     << a << ", 1, _rnd);\n";
+                                a = r;
+                        }
+                        emit(mf.name, r, a);
+                        return r;
+                }
+        }
+        throw std::domain_error("print_csrc_function(): function "
+                        + f.get_name() + " has no C library function");
+}
+
+void csrc_generator::print_function(const std::string & name, const ex & e)
+{
+        horner_form horner(params);
+        std::string result = lower(horner(e));
+        std::ostream & s = ctx.s;
+
+        if (not mpfr) {
+                s << "double " << name << "(";
+                for (size_t i=0; i<params.size(); i++)
+                        s << (i > 0 ? ", " : "") << "double "
+                          << ex_to<symbol>(params[i]).get_name();
+                if (params.empty())
+                        s << "void";
+                s << ")\n{\n" << body.str()
+                  << "        return " << result << ";\n}\n";
+                return;
+        }
+
+        s << "void " << name << "(mpfr_ptr _result";
+        for (const auto & x : params)
+                s << ", mpfr_srcptr " << ex_to<symbol>(x).get_name();
+        s << ", mpfr_rnd_t _rnd)\n{\n";
+        if (num_regs > 0)
+                s << "        mpfr_t _t[" << num_regs << "];\n"
+                  << "        for (int _i = 0; _i < " << num_regs << "; _i++)\n"
+                  << "                mpfr_init2(_t[_i], mpfr_get_prec(_result));\n";
+        s << body.str()
+          << "        mpfr_set(_result, " << result << ", _rnd);\n";
+        if (num_regs > 0)
+                s << "        for (int _i = 0; _i < " << num_regs << "; _i++)\n"
+                  << "                mpfr_clear(_t[_i]);\n";
+        s << "}\n";
+}
+
+void print_csrc_function(const print_csrc & c, const std::string & name,
+                         const ex & e, const lst & args)
+{
+        csrc_generator gen(c, args);
+        gen.print_function(name, e);
+}
+
+} // namespace GiNaC
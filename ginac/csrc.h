@@ -0,0 +1,56 @@
+/** @file csrc.h
+ *
+ *  Interface to the output of expressions as C functions. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_CSRC_H__
+#define __PYNAC_CSRC_H__
+
+#include "ex.h"
+#include "lst.h"
+#include "print.h"
+
+#include <string>
+
+namespace GiNaC {
+
+/** Print a C function called name that computes e from the symbols args,
+ *  in the arithmetic given by c.type:
+ *
+ *    double name(double x, double y)
+ *    void name(mpfr_ptr _result, mpfr_srcptr x, mpfr_srcptr y, mpfr_rnd_t _rnd)
+ *
+ *  The code is straight-line.  Equal subexpressions are computed once,
+ *  polynomial sums in the arguments are evaluated in Horner form, and
+ *  integer powers are computed by repeated squaring.  The generated code
+ *  needs <math.h> or <mpfr.h>.
+ *
+ *  The expression may contain what compiled_ex accepts, except that with
+ *  doubles psi, zeta and Li2 are not available.
+ *
+ *  @exception invalid_argument (e contains other symbols, or the name of
+ *             an argument is not a C identifier, or is a C keyword or the
+ *             name of a function the code calls)
+ *  @exception domain_error (e contains other kinds of objects)
+ *  @see compiled_ex */
+void print_csrc_function(const print_csrc & c, const std::string & name,
+                         const ex & e, const lst & args);
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_CSRC_H__
@@ -0,0 +1,267 @@
+/** @file evalf_ball.cpp
+ *
+ *  Evaluation of expressions in ball arithmetic with automatic precision
+ *  increase. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "evalf_ball.h"
+#include "ball.h"
+#include "add.h"
+#include "mul.h"
+#include "power.h"
+#include "constant.h"
+#include "function.h"
+#include "inifcns.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace GiNaC {
+
+ball_accuracy_error::ball_accuracy_error(const numeric& b)
+  : std::runtime_error("evalf_ball(): requested accuracy not reached"),
+    best(b)
+{
+}
+
+static void abs_ball(acb_ptr r, acb_srcptr z, slong prec)
+{
+        arb_t a;
+        arb_init(a);
+        acb_abs(a, z, prec);
+        acb_set_arb(r, a);
+        arb_clear(a);
+}
+
+static void Li2_ball(acb_ptr r, acb_srcptr z, slong prec)
+{
+        acb_polylog_si(r, 2, z, prec);
+}
+
+static void factorial_ball(acb_ptr r, acb_srcptr z, slong prec)
+{
+        acb_t t;
+        acb_init(t);
+        acb_add_ui(t, z, 1, prec);
+        acb_gamma(r, t, prec);
+        acb_clear(t);
+}
+
+using ballfun_t = decltype(abs_ball);
+using funcmap_t = std::unordered_map<unsigned int,ballfun_t*>;
+
+static funcmap_t& funcmap()
+{
+        static funcmap_t _funcmap = {{
+                {exp_SERIAL::serial, &acb_exp},
+                {log_SERIAL::serial, &acb_log},
+                {sin_SERIAL::serial, &acb_sin},
+                {cos_SERIAL::serial, &acb_cos},
+                {tan_SERIAL::serial, &acb_tan},
+                {cot_SERIAL::serial, &acb_cot},
+                {sec_SERIAL::serial, &acb_sec},
+                {csc_SERIAL::serial, &acb_csc},
+                {asin_SERIAL::serial, &acb_asin},
+                {acos_SERIAL::serial, &acb_acos},
+                {atan_SERIAL::serial, &acb_atan},
+                {sinh_SERIAL::serial, &acb_sinh},
+                {cosh_SERIAL::serial, &acb_cosh},
+                {tanh_SERIAL::serial, &acb_tanh},
+                {coth_SERIAL::serial, &acb_coth},
+                {sech_SERIAL::serial, &acb_sech},
+                {csch_SERIAL::serial, &acb_csch},
+                {asinh_SERIAL::serial, &acb_asinh},
+                {acosh_SERIAL::serial, &acb_acosh},
+                {atanh_SERIAL::serial, &acb_atanh},
+                {gamma_SERIAL::serial, &acb_gamma},
+                {lgamma_SERIAL::serial, &acb_lgamma},
+                {psi1_SERIAL::serial, &acb_digamma},
+                {zeta1_SERIAL::serial, &acb_zeta},
+                {abs_SERIAL::serial, &abs_ball},
+                {Li2_SERIAL::serial, &Li2_ball},
+                {factorial_SERIAL::serial, &factorial_ball},
+        }};
+
+        return _funcmap;
+}
+
+bool evalf_ball_can_handle(const ex& e)
+{
+        if (is_exactly_a<numeric>(e)) {
+                const numeric& num = ex_to<numeric>(e);
+                if (not num.is_pyobject())
+                        return true;
+                return PyFloat_Check(num.v._pyobject)
+                        or PyComplex_Check(num.v._pyobject);
+        }
+        if (is_exactly_a<constant>(e)) {
+                const constant& c = ex_to<constant>(e);
+                return c.get_serial() == Pi.get_serial()
+                        or c.get_serial() == Euler.get_serial()
+                        or c.get_serial() == Catalan.get_serial();
+        }
+        if (is_exactly_a<function>(e)) {
+                const function& f = ex_to<function>(e);
+                if (f.nops() != 1
+                    or funcmap().find(f.get_serial()) == funcmap().end())
+                        return false;
+                return evalf_ball_can_handle(f.op(0));
+        }
+        if (is_exactly_a<power>(e))
+                return evalf_ball_can_handle(e.op(0))
+                        and evalf_ball_can_handle(e.op(1));
+        if (is_exactly_a<add>(e) or is_exactly_a<mul>(e)) {
+                for (size_t i=0; i<e.nops(); i++)
+                        if (not evalf_ball_can_handle(e.op(i)))
+                                return false;
+                return true;
+        }
+        return false;
+}
+
+/** Evaluates expressions at a fixed working precision.  Shared
+ *  subexpressions are evaluated only once per evaluator. */
+class ball_evaluator {
+public:
+        explicit ball_evaluator(slong p) : prec(p) {}
+        void eval(acb_ptr r, const ex& e);
+private:
+        void compute(acb_ptr r, const ex& e);
+        slong prec;
+        std::unordered_map<const basic*, numeric> seen;
+};
+
+void ball_evaluator::eval(acb_ptr r, const ex& e)
+{
+        const basic& b = ex_to<basic>(e);
+        if (b.nops() == 0 or b.get_refcount() <= 1) {
+                compute(r, e);
+                return;
+        }
+        auto it = seen.find(&b);
+        if (it != seen.end()) {
+                acb_set(r, &it->second.as_ball()->z);
+                return;
+        }
+        compute(r, e);
+        ball_ptr ball;
+        ball_init(ball, prec);
+        acb_set(&ball->z, r);
+        seen.emplace(&b, numeric(ball));
+}
+
+void ball_evaluator::compute(acb_ptr r, const ex& e)
+{
+        if (is_exactly_a<numeric>(e)) {
+                const numeric b = ex_to<numeric>(e).to_ball(prec);
+                acb_set(r, &b.as_ball()->z);
+                return;
+        }
+        if (is_exactly_a<constant>(e)) {
+                unsigned serial = ex_to<constant>(e).get_serial();
+                acb_zero(r);
+                if (serial == Pi.get_serial())
+                        arb_const_pi(acb_realref(r), prec);
+                else if (serial == Euler.get_serial())
+                        arb_const_euler(acb_realref(r), prec);
+                else if (serial == Catalan.get_serial())
+                        arb_const_catalan(acb_realref(r), prec);
+                else
+                        throw std::domain_error("evalf_ball(): constant not handled");
+                return;
+        }
+        if (is_exactly_a<add>(e) or is_exactly_a<mul>(e)) {
+                bool is_add = is_exactly_a<add>(e);
+                acb_t t;
+                acb_init(t);
+                eval(r, e.op(0));
+                for (size_t i=1; i<e.nops(); i++) {
+                        eval(t, e.op(i));
+                        if (is_add)
+                                acb_add(r, r, t, prec);
+                        else
+                                acb_mul(r, r, t, prec);
+                }
+                acb_clear(t);
+                return;
+        }
+        if (is_exactly_a<power>(e)) {
+                const ex& expo = e.op(1);
+                acb_t base;
+                acb_init(base);
+                eval(base, e.op(0));
+                if (is_exactly_a<numeric>(expo)
+                    and ex_to<numeric>(expo).is_long())
+                        acb_pow_si(r, base, ex_to<numeric>(expo).to_long(),
+                                   prec);
+                else if (expo.is_equal(_ex1_2))
+                        acb_sqrt(r, base, prec);
+                else if (expo.is_equal(_ex_1_2))
+                        acb_rsqrt(r, base, prec);
+                else {
+                        acb_t t;
+                        acb_init(t);
+                        eval(t, expo);
+                        acb_pow(r, base, t, prec);
+                        acb_clear(t);
+                }
+                acb_clear(base);
+                return;
+        }
+        if (is_exactly_a<function>(e)) {
+                const function& f = ex_to<function>(e);
+                auto search = funcmap().find(f.get_serial());
+                if (f.nops() != 1 or search == funcmap().end())
+                        throw std::domain_error("evalf_ball(): function not handled");
+                acb_t arg;
+                acb_init(arg);
+                eval(arg, f.op(0));
+                search->second(r, arg, prec);
+                acb_clear(arg);
+                return;
+        }
+        throw std::domain_error("evalf_ball(): expression not handled");
+}
+
+numeric evalf_ball(const ex& e, long prec, long max_prec)
+{
+        if (prec < 2)
+                throw std::invalid_argument("evalf_ball(): invalid precision");
+        if (not evalf_ball_can_handle(e))
+                throw std::domain_error("evalf_ball(): expression not handled");
+        if (max_prec == 0)
+                max_prec = 16 * prec;
+        ball_ptr ball;
+        ball_init(ball, prec);
+        // a few guard bits absorb the rounding errors of short expressions
+        for (slong wp = prec + 16; ; wp *= 2) {
+                wp = std::min<slong>(wp, std::max(max_prec, prec));
+                ball_evaluator ev(wp);
+                ev.eval(&ball->z, e);
+                if (acb_rel_accuracy_bits(&ball->z) >= prec)
+                        return ball;
+                if (wp >= max_prec)
+                        break;
+        }
+        throw ball_accuracy_error(ball);
+}
+
+} // namespace GiNaC
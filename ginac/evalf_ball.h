@@ -0,0 +1,60 @@
+/** @file evalf_ball.h
+ *
+ *  Interface to the evaluation of expressions in ball arithmetic. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_EVALF_BALL_H__
+#define __PYNAC_EVALF_BALL_H__
+
+#include "ex.h"
+#include "numeric.h"
+
+#include <stdexcept>
+
+namespace GiNaC {
+
+/** Exception thrown by evalf_ball() if the requested accuracy is not
+ *  reached below the precision limit, e.g. because the exact value is
+ *  zero but not recognized as such. */
+class ball_accuracy_error : public std::runtime_error {
+public:
+        ball_accuracy_error(const numeric& b);
+        /** The best enclosure that was computed. */
+        const numeric& ball() const { return best; }
+private:
+        numeric best;
+};
+
+/** True if evalf_ball() can evaluate the expression, that is, if it is
+ *  built from numbers, the constants Pi, Euler and Catalan, sums, products,
+ *  powers and functions that have a ball implementation. */
+bool evalf_ball_can_handle(const ex& e);
+
+/** Evaluate e in ball arithmetic.  The working precision starts a little
+ *  above prec bits and is doubled until the result has a relative accuracy
+ *  of prec bits.  The result is a ball of precision prec that contains the
+ *  exact value.
+ *
+ *  @param max_prec  highest working precision, 0 for 16*prec
+ *  @exception domain_error (not evalf_ball_can_handle(e))
+ *  @exception ball_accuracy_error (accuracy not reached) */
+numeric evalf_ball(const ex& e, long prec, long max_prec = 0);
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_EVALF_BALL_H__
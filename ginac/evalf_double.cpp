@@ -0,0 +1,328 @@
+/** @file evalf_double.cpp
+ *
+ *  Evaluation of expressions in machine doubles. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "evalf_double.h"
+#include "ex.h"
+#include "numeric.h"
+#include "add.h"
+#include "mul.h"
+#include "power.h"
+#include "constant.h"
+#include "function.h"
+#include "inifcns.h"
+#include "operators.h"
+#include "utils.h"
+
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace GiNaC {
+
+using cdouble = std::complex<double>;
+
+/** Evaluates expressions to T, which is double or std::complex<double>.
+ *  Functions with a kernel in funcmap() are computed by the C++ library,
+ *  others by their evalf() with the arguments already evaluated.  Shared
+ *  subexpressions are evaluated only once per evaluator. */
+template <typename T>
+class double_evaluator {
+public:
+        using fun_t = T(T);
+        T eval(const ex& e);
+        static fun_t* kernel(unsigned serial);
+private:
+        using funcmap_t = std::unordered_map<unsigned int,fun_t*>;
+        static const funcmap_t& funcmap();
+        static T from_numeric(const numeric& n);
+        static numeric to_numeric(T x);
+        static T int_power(T x, long n);
+        T compute(const ex& e);
+        T eval_power(T base, const ex& expo);
+        T eval_function(const function& f);
+        std::unordered_map<const basic*, T> seen;
+};
+
+static const double not_a_number = std::numeric_limits<double>::quiet_NaN();
+
+template <>
+const double_evaluator<double>::funcmap_t& double_evaluator<double>::funcmap()
+{
+        static funcmap_t _funcmap = {{
+                {exp_SERIAL::serial, [](double x) { return std::exp(x); }},
+                {log_SERIAL::serial, [](double x) { return std::log(x); }},
+                {sin_SERIAL::serial, [](double x) { return std::sin(x); }},
+                {cos_SERIAL::serial, [](double x) { return std::cos(x); }},
+                {tan_SERIAL::serial, [](double x) { return std::tan(x); }},
+                {cot_SERIAL::serial, [](double x) { return 1 / std::tan(x); }},
+                {sec_SERIAL::serial, [](double x) { return 1 / std::cos(x); }},
+                {csc_SERIAL::serial, [](double x) { return 1 / std::sin(x); }},
+                {asin_SERIAL::serial, [](double x) { return std::asin(x); }},
+                {acos_SERIAL::serial, [](double x) { return std::acos(x); }},
+                {atan_SERIAL::serial, [](double x) { return std::atan(x); }},
+                {sinh_SERIAL::serial, [](double x) { return std::sinh(x); }},
+                {cosh_SERIAL::serial, [](double x) { return std::cosh(x); }},
+                {tanh_SERIAL::serial, [](double x) { return std::tanh(x); }},
+                {coth_SERIAL::serial, [](double x) { return 1 / std::tanh(x); }},
+                {sech_SERIAL::serial, [](double x) { return 1 / std::cosh(x); }},
+                {csch_SERIAL::serial, [](double x) { return 1 / std::sinh(x); }},
+                {asinh_SERIAL::serial, [](double x) { return std::asinh(x); }},
+                {acosh_SERIAL::serial, [](double x) { return std::acosh(x); }},
+                {atanh_SERIAL::serial, [](double x) { return std::atanh(x); }},
+                {acot_SERIAL::serial, [](double x) { return std::atan(1 / x); }},
+                {asec_SERIAL::serial, [](double x) { return std::acos(1 / x); }},
+                {acsc_SERIAL::serial, [](double x) { return std::asin(1 / x); }},
+                {acoth_SERIAL::serial, [](double x) { return std::atanh(1 / x); }},
+                {asech_SERIAL::serial, [](double x) { return std::acosh(1 / x); }},
+                {acsch_SERIAL::serial, [](double x) { return std::asinh(1 / x); }},
+                {abs_SERIAL::serial, [](double x) { return std::fabs(x); }},
+                {gamma_SERIAL::serial, [](double x) { return std::tgamma(x); }},
+                {factorial_SERIAL::serial, [](double x) { return std::tgamma(x + 1); }},
+                // log(gamma(x)) is complex for negative gamma(x)
+                {lgamma_SERIAL::serial, [](double x) {
+                        return (x > 0) ? std::lgamma(x) : not_a_number; }},
+        }};
+
+        return _funcmap;
+}
+
+template <>
+const double_evaluator<cdouble>::funcmap_t& double_evaluator<cdouble>::funcmap()
+{
+        static funcmap_t _funcmap = {{
+                {exp_SERIAL::serial, [](cdouble z) { return std::exp(z); }},
+                {log_SERIAL::serial, [](cdouble z) { return std::log(z); }},
+                {sin_SERIAL::serial, [](cdouble z) { return std::sin(z); }},
+                {cos_SERIAL::serial, [](cdouble z) { return std::cos(z); }},
+                {tan_SERIAL::serial, [](cdouble z) { return std::tan(z); }},
+                {cot_SERIAL::serial, [](cdouble z) { return 1. / std::tan(z); }},
+                {sec_SERIAL::serial, [](cdouble z) { return 1. / std::cos(z); }},
+                {csc_SERIAL::serial, [](cdouble z) { return 1. / std::sin(z); }},
+                {asin_SERIAL::serial, [](cdouble z) { return std::asin(z); }},
+                {acos_SERIAL::serial, [](cdouble z) { return std::acos(z); }},
+                {atan_SERIAL::serial, [](cdouble z) { return std::atan(z); }},
+                {sinh_SERIAL::serial, [](cdouble z) { return std::sinh(z); }},
+                {cosh_SERIAL::serial, [](cdouble z) { return std::cosh(z); }},
+                {tanh_SERIAL::serial, [](cdouble z) { return std::tanh(z); }},
+                {coth_SERIAL::serial, [](cdouble z) { return 1. / std::tanh(z); }},
+                {sech_SERIAL::serial, [](cdouble z) { return 1. / std::cosh(z); }},
+                {csch_SERIAL::serial, [](cdouble z) { return 1. / std::sinh(z); }},
+                {asinh_SERIAL::serial, [](cdouble z) { return std::asinh(z); }},
+                {acosh_SERIAL::serial, [](cdouble z) { return std::acosh(z); }},
+                {atanh_SERIAL::serial, [](cdouble z) { return std::atanh(z); }},
+                {acot_SERIAL::serial, [](cdouble z) { return std::atan(1. / z); }},
+                {asec_SERIAL::serial, [](cdouble z) { return std::acos(1. / z); }},
+                {acsc_SERIAL::serial, [](cdouble z) { return std::asin(1. / z); }},
+                {acoth_SERIAL::serial, [](cdouble z) { return std::atanh(1. / z); }},
+                {asech_SERIAL::serial, [](cdouble z) { return std::acosh(1. / z); }},
+                {acsch_SERIAL::serial, [](cdouble z) { return std::asinh(1. / z); }},
+                {abs_SERIAL::serial, [](cdouble z) { return cdouble(std::abs(z)); }},
+        }};
+
+        return _funcmap;
+}
+
+// Numbers that are not real become NaN.
+template <>
+double double_evaluator<double>::from_numeric(const numeric& n)
+{
+        if (n.is_real())
+                return n.to_double();
+        return not_a_number;
+}
+
+template <>
+cdouble double_evaluator<cdouble>::from_numeric(const numeric& n)
+{
+        if (n.is_real())
+                return n.to_double();
+        return cdouble(n.real().to_double(), n.imag().to_double());
+}
+
+template <>
+numeric double_evaluator<double>::to_numeric(double x)
+{
+        return x;
+}
+
+template <>
+numeric double_evaluator<cdouble>::to_numeric(cdouble z)
+{
+        if (z.imag() == 0)
+                return z.real();
+        return numeric(z.real()) + numeric(z.imag()) * I;
+}
+
+template <>
+double double_evaluator<double>::int_power(double x, long n)
+{
+        return std::pow(x, static_cast<double>(n));
+}
+
+// std::pow() of complex numbers goes through exp(log(z)), which is
+// inexact even for small Gaussian integers, so use repeated squaring.
+template <>
+cdouble double_evaluator<cdouble>::int_power(cdouble z, long n)
+{
+        return cdouble_int_power(z, n);
+}
+
+cdouble cdouble_int_power(cdouble z, long n)
+{
+        unsigned long e = n < 0 ? -static_cast<unsigned long>(n) : n;
+        cdouble acc = 1;
+        while (e != 0) {
+                if ((e & 1) != 0)
+                        acc *= z;
+                e >>= 1;
+                if (e != 0)
+                        z *= z;
+        }
+        return n < 0 ? 1. / acc : acc;
+}
+
+template <typename T>
+typename double_evaluator<T>::fun_t* double_evaluator<T>::kernel(unsigned serial)
+{
+        auto search = funcmap().find(serial);
+        if (search == funcmap().end())
+                return nullptr;
+        return search->second;
+}
+
+template <typename T>
+T double_evaluator<T>::eval_function(const function& f)
+{
+        if (f.nops() == 1) {
+                fun_t* fun = kernel(f.get_serial());
+                if (fun != nullptr)
+                        return fun(eval(f.op(0)));
+        }
+        exvector args;
+        args.reserve(f.nops());
+        for (size_t i=0; i<f.nops(); i++)
+                args.push_back(to_numeric(eval(f.op(i))));
+        ex result = function(f.get_serial(), args).evalf();
+        if (not is_exactly_a<numeric>(result))
+                throw std::runtime_error("evalf_double(): function value is not a number");
+        return from_numeric(ex_to<numeric>(result));
+}
+
+template <typename T>
+T double_evaluator<T>::eval_power(T base, const ex& expo)
+{
+        if (is_exactly_a<numeric>(expo)) {
+                const numeric& n = ex_to<numeric>(expo);
+                if (n.is_long())
+                        return int_power(base, n.to_long());
+                if (n.is_equal(*_num1_2_p))
+                        return std::sqrt(base);
+        }
+        return std::pow(base, eval(expo));
+}
+
+template <typename T>
+T double_evaluator<T>::eval(const ex& e)
+{
+        const basic& b = ex_to<basic>(e);
+        if (b.nops() == 0 or b.get_refcount() <= 1)
+                return compute(e);
+        auto it = seen.find(&b);
+        if (it != seen.end())
+                return it->second;
+        T result = compute(e);
+        seen.emplace(&b, result);
+        return result;
+}
+
+// The pairs of sums and products are evaluated directly, op() would
+// build a node for each.
+template <typename T>
+T double_evaluator<T>::compute(const ex& e)
+{
+        if (is_exactly_a<numeric>(e))
+                return from_numeric(ex_to<numeric>(e));
+        if (is_exactly_a<add>(e)) {
+                const add& a = ex_to<add>(e);
+                T sum = from_numeric(a.get_overall_coeff());
+                for (const auto& p : a.get_seq())
+                        sum += from_numeric(ex_to<numeric>(p.coeff)) * eval(p.rest);
+                return sum;
+        }
+        if (is_exactly_a<mul>(e)) {
+                const mul& m = ex_to<mul>(e);
+                T prod = from_numeric(m.get_overall_coeff());
+                for (const auto& p : m.get_seq())
+                        prod *= eval_power(eval(p.rest), p.coeff);
+                return prod;
+        }
+        if (is_exactly_a<power>(e))
+                return eval_power(eval(e.op(0)), e.op(1));
+        if (is_exactly_a<function>(e))
+                return eval_function(ex_to<function>(e));
+        if (is_exactly_a<constant>(e)) {
+                unsigned serial = ex_to<constant>(e).get_serial();
+                if (serial == Pi.get_serial())
+                        return 3.14159265358979323846;
+                if (serial == Euler.get_serial())
+                        return 0.57721566490153286061;
+                if (serial == Catalan.get_serial())
+                        return 0.91596559417721901505;
+        }
+        ex result = e.evalf();
+        if (not is_exactly_a<numeric>(result))
+                throw std::runtime_error("evalf_double(): expression is not numeric");
+        return from_numeric(ex_to<numeric>(result));
+}
+
+/** Evaluate the expression in machine doubles, computing functions with
+ *  the C library where possible.  Non-real values, including those of
+ *  functions outside of their real domain, are NaN; see evalf_cdouble().
+ *
+ *  @exception runtime_error (expression contains symbols) */
+double ex::evalf_double() const
+{
+        double_evaluator<double> ev;
+        return ev.eval(*this);
+}
+
+/** Evaluate the expression in complex machine doubles, computing functions
+ *  with the C++ library where possible.
+ *
+ *  @exception runtime_error (expression contains symbols) */
+std::complex<double> ex::evalf_cdouble() const
+{
+        double_evaluator<cdouble> ev;
+        return ev.eval(*this);
+}
+
+double_kernel_t double_kernel(unsigned serial)
+{
+        return double_evaluator<double>::kernel(serial);
+}
+
+cdouble_kernel_t cdouble_kernel(unsigned serial)
+{
+        return double_evaluator<cdouble>::kernel(serial);
+}
+
+} // namespace GiNaC
@@ -0,0 +1,43 @@
+/** @file evalf_double.h
+ *
+ *  Native kernels of functions in machine doubles, shared by
+ *  ex::evalf_double() and compiled expressions. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_EVALF_DOUBLE_H__
+#define __PYNAC_EVALF_DOUBLE_H__
+
+#include <complex>
+
+namespace GiNaC {
+
+using double_kernel_t = double (*)(double);
+using cdouble_kernel_t = std::complex<double> (*)(std::complex<double>);
+
+/** The kernel of the one-argument function with the given serial,
+ *  nullptr if it has none. */
+double_kernel_t double_kernel(unsigned serial);
+cdouble_kernel_t cdouble_kernel(unsigned serial);
+
+/** z**n by repeated squaring, which unlike std::pow() is exact for small
+ *  Gaussian integers. */
+std::complex<double> cdouble_int_power(std::complex<double> z, long n);
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_EVALF_DOUBLE_H__
@@ -38,9 +38,17 @@
 #include "operators.h"
 #include "wildcard.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
 #include <unordered_map>
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+#include <mutex>
+#endif
 
 namespace GiNaC {
 
@@ -78,12 +86,160 @@ void ex::dbgprinttree() const
 	bp->dbgprinttree();
 }
 
+namespace {
+
+/** Table of the results of expand() during a call with the option
+ *  expand_options::expand_shared, keyed on the address of the expanded
+ *  object and the options.  The entries keep the original expression
+ *  alive, so an address cannot be reused while the table exists. */
+class expand_memo {
+public:
+	expand_memo() { current = this; }
+	~expand_memo() { current = nullptr; }
+
+	typedef std::pair<const basic *, unsigned> key_type;
+	struct key_hash {
+		size_t operator()(const key_type & k) const
+		{
+			return std::hash<const basic *>()(k.first) ^ k.second;
+		}
+	};
+	std::unordered_map<key_type, std::pair<ex, ex>, key_hash> table;
+
+	static thread_local expand_memo *current;
+};
+
+thread_local expand_memo *expand_memo::current = nullptr;
+
+} // anonymous namespace
+
+/** Expand products and integer powers of sums.  With the option
+ *  expand_options::expand_shared every object that is referenced more
+ *  than once in the expression tree is expanded only once for the whole
+ *  call, which pays off for expressions where the same large factor
+ *  occurs many times. */
 ex ex::expand(unsigned options) const
 {
+	if ((options & expand_options::expand_shared) != 0u) {
+		options &= ~expand_options::expand_shared;
+		if (expand_memo::current == nullptr) {
+			expand_memo memo;
+			return expand(options);
+		}
+	}
+
 	if (options == 0 && ((bp->flags & status_flags::expanded) != 0u)) // The "expanded" flag only covers the standard options; someone might want to re-expand with different options
 		return *this;
 
-        return bp->expand(options);
+	// Objects without operands are cheap to expand, and an object held
+	// by just this reference occurs only once in the tree.
+	expand_memo *memo = expand_memo::current;
+	if (memo == nullptr or bp->get_refcount() <= 1 or bp->nops() == 0)
+		return bp->expand(options);
+
+	const expand_memo::key_type key(&*bp, options);
+	auto it = memo->table.find(key);
+	if (it != memo->table.end())
+		return it->second.second;
+	ex result = bp->expand(options);
+	memo->table.emplace(key, std::make_pair(*this, result));
+	return result;
+}
+
+/** Computes upper bounds for the number of terms of expanded expressions,
+ *  assuming that no terms combine or cancel.  Shared subexpressions are
+ *  counted only once per estimator.  The bounds are doubles, so that
+ *  huge ones saturate to infinity instead of overflowing. */
+namespace {
+
+class expand_estimator {
+public:
+	double terms(const ex & e);
+	static double power_terms(double k, const ex & expo);
+private:
+	double compute_terms(const ex & e);
+	std::unordered_map<const basic *, double> seen;
+};
+
+/** Number of terms of (t_1+...+t_k)^n with distinct monomials t_i, that is,
+ *  binomial(n+k-1,k-1).  Exponents other than positive integers keep the
+ *  power as a single term. */
+double expand_estimator::power_terms(double k, const ex & expo)
+{
+	if (k <= 1)
+		return 1;
+	if (not is_exactly_a<numeric>(expo))
+		return 1;
+	const numeric & num = ex_to<numeric>(expo);
+	if (not num.is_pos_integer())
+		return 1;
+	if (not num.is_long() or std::isinf(k))
+		return HUGE_VAL;
+	const double n = num.to_long();
+	const double r = std::min(n, k - 1);
+	const double N = n + k - 1;
+	double result = 1;
+	for (double i=1; i<=r; ++i) {
+		result = result * (N - r + i) / i;
+		if (result > 1e30)
+			return HUGE_VAL;
+	}
+	return result;
+}
+
+double expand_estimator::terms(const ex & e)
+{
+	const basic & b = ex_to<basic>(e);
+	if (b.nops() == 0)
+		return 1;
+	if (b.get_refcount() <= 1)
+		return compute_terms(e);
+	auto it = seen.find(&b);
+	if (it != seen.end())
+		return it->second;
+	const double result = compute_terms(e);
+	seen.emplace(&b, result);
+	return result;
+}
+
+double expand_estimator::compute_terms(const ex & e)
+{
+	// The pairs are read directly, op() would build a node for each.
+	if (is_exactly_a<add>(e)) {
+		const add & a = ex_to<add>(e);
+		double result = a.get_overall_coeff().is_zero() ? 0 : 1;
+		for (const auto & p : a.get_seq())
+			result += terms(p.rest);
+		return result;
+	}
+	if (is_exactly_a<mul>(e)) {
+		const mul & m = ex_to<mul>(e);
+		double result = 1;
+		for (const auto & p : m.get_seq())
+			result *= power_terms(terms(p.rest), p.coeff);
+		return result;
+	}
+	if (is_exactly_a<power>(e))
+		return power_terms(terms(e.op(0)), e.op(1));
+	return 1;
+}
+
+} // anonymous namespace
+
+/** Estimate the number of terms of expand() without expanding, as an upper
+ *  bound that ignores combining and cancellation of terms.  Sums, products
+ *  and positive integer powers of sums are taken into account, anything
+ *  else counts as a single term.  The estimate saturates at the largest
+ *  size_t value.
+ *
+ *  @see set_expand_budget */
+size_t ex::expand_size_estimate() const
+{
+	expand_estimator est;
+	const double n = est.terms(*this);
+	if (n >= static_cast<double>(std::numeric_limits<size_t>::max()))
+		return std::numeric_limits<size_t>::max();
+	return static_cast<size_t>(n);
 }
 
 /** Compute partial derivative of an expression.
@@ -280,16 +436,15 @@ ex & ex::operator[](size_t i)
 
 bool ex::is_equal(const ex & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_is_equals++;
-#endif
+	GINAC_COUNT_COMPARE(cc_total_is_equals);
 	if (bp == other.bp)  // trivial case: both expressions point to same basic
 		return true;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.nontrivial_is_equals++;
-#endif
+	GINAC_COUNT_COMPARE(cc_nontrivial_is_equals);
 	if (is_exactly_a<numeric>(*this) and is_exactly_a<numeric>(other))
 		return ex_to<numeric>(*this).is_equal(ex_to<numeric>(other));
+	// two different canonical instances cannot be equal
+	if ((bp->flags & other.bp->flags & status_flags::interned) != 0u)
+		return false;
 	const bool equal = bp->is_equal(*other.bp);
 #if 0
 	if (equal) {
@@ -304,14 +459,10 @@ bool ex::is_equal(const ex & other) const
 
 int ex::compare(const ex & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_compares++;
-#endif
+	GINAC_COUNT_COMPARE(cc_total_compares);
 	if (bp == other.bp)  // trivial case: both expressions point to same basic
 		return 0;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.nontrivial_compares++;
-#endif
+	GINAC_COUNT_COMPARE(cc_nontrivial_compares);
 	if (is_exactly_a<numeric>(*this) and is_exactly_a<numeric>(other))
 		return ex_to<numeric>(*this).compare_same_type(ex_to<numeric>(other));
 	const int cmpval = bp->compare(*other.bp);
@@ -885,12 +1036,19 @@ void ex::makewriteable()
 	GINAC_ASSERT(bp->flags & status_flags::dynallocated);
 	bp.makewritable();
 	GINAC_ASSERT(bp->get_refcount() == 1);
+	// the caller is going to change the object, so it can no longer
+	// be the canonical instance
+	if ((bp->flags & status_flags::interned) != 0u)
+		remove_from_unique_table(*bp);
 }
 
 /** Share equal objects between expressions.
+ *  With thread-safe reference counting this is a no-op, because the
+ *  expressions compared may be read by other threads at the same time.
  *  @see ex::compare(const ex &) */
 void ex::share(const ex & other) const
 {
+#ifndef PYNAC_THREADSAFE_REFCOUNT
 	if (((bp->flags | other.bp->flags) & status_flags::not_shareable) != 0u)
 		return;
 
@@ -898,6 +1056,179 @@ void ex::share(const ex & other) const
 		bp = other.bp;
 	else
 		other.bp = bp;
+#endif
+}
+
+//////////
+// hash-consing
+//////////
+
+namespace {
+
+// read without the table lock by ex::construct_from_basic()
+std::atomic<bool> hash_consing(false);
+
+using unique_table_t = std::unordered_multimap<long, basic *>;
+
+// Never destroyed, as objects are removed from it by static destructors.
+unique_table_t & unique_table()
+{
+	static auto t = new unique_table_t;
+	return *t;
+}
+
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+std::mutex & unique_table_mutex()
+{
+	static auto m = new std::mutex;
+	return *m;
+}
+#define UNIQUE_TABLE_LOCK std::lock_guard<std::mutex> lock(unique_table_mutex())
+#else
+#define UNIQUE_TABLE_LOCK
+#endif
+
+unsigned long table_generation = 0;
+
+/** Return the canonical instance of the evaluated object held by p,
+ *  entering p into the table if there is none yet. */
+ptr<basic> intern(const ptr<basic> & p)
+{
+	const basic & b = *p;
+	if (((b.flags & (status_flags::interned | status_flags::not_shareable)) != 0u)
+	    or is_exactly_a<numeric>(b))
+		return p;
+	const long h = b.gethash();
+	if ((b.flags & status_flags::hash_calculated) == 0u)
+		return p;
+
+	// The comparisons are done without holding the lock, since they may
+	// create and destroy expressions themselves.  If the table got a new
+	// entry in the meantime we start over, so there is never more than
+	// one canonical instance of an object.
+	for (;;) {
+		std::vector<basic *> candidates;
+		unsigned long generation;
+		{
+			UNIQUE_TABLE_LOCK;
+			generation = table_generation;
+			auto range = unique_table().equal_range(h);
+			for (auto it = range.first; it != range.second; ++it) {
+				basic *c = it->second;
+				// pin c, another thread may be destroying it
+				if (c->tinfo() == b.tinfo() and c->try_add_reference())
+					candidates.push_back(c);
+			}
+		}
+		basic *found = nullptr;
+		for (basic *c : candidates)
+			if (found == nullptr and c->is_equal_same_type(b))
+				found = c;
+		ptr<basic> result = found != nullptr ? ptr<basic>(*found) : p;
+		for (basic *c : candidates)
+			if (c->remove_reference() == 0)
+				release_queue<basic>::release(c);
+		if (found != nullptr)
+			return result;
+
+		UNIQUE_TABLE_LOCK;
+		if (not hash_consing)
+			return p;
+		if (generation != table_generation)
+			continue;
+		// set under the lock, like remove_from_unique_table() clears it
+		b.setflag(status_flags::interned);
+		unique_table().emplace(h, const_cast<basic *>(&b));
+		++table_generation;
+		return p;
+	}
+}
+
+} // anonymous namespace
+
+void remove_from_unique_table(const basic & obj)
+{
+	UNIQUE_TABLE_LOCK;
+	unique_table_t & table = unique_table();
+	auto range = table.equal_range(obj.hashvalue);
+	for (auto it = range.first; it != range.second; ++it)
+		if (it->second == &obj) {
+			table.erase(it);
+			break;
+		}
+	obj.clearflag(status_flags::interned);
+}
+
+void set_hash_consing(bool enable)
+{
+	UNIQUE_TABLE_LOCK;
+	if (not enable) {
+		for (auto & elem : unique_table())
+			elem.second->clearflag(status_flags::interned);
+		unique_table().clear();
+		++table_generation;
+	}
+	hash_consing = enable;
+}
+
+bool hash_consing_enabled()
+{
+	return hash_consing;
+}
+
+size_t hash_consing_table_size()
+{
+	UNIQUE_TABLE_LOCK;
+	return unique_table().size();
+}
+
+static std::atomic<size_t> expand_term_budget(0);
+static std::atomic<size_t> expand_byte_budget(0);
+
+// Rough lower bound for the memory of one expanded term: its pair in the
+// sum, a product node and its coefficient.
+static const size_t expand_bytes_per_term = sizeof(expair) + sizeof(mul) + sizeof(numeric);
+
+static std::string expand_budget_message(size_t terms, size_t budget)
+{
+	std::ostringstream os;
+	os << "expand(): expansion would produce " << terms
+	   << " terms, the budget is " << budget;
+	return os.str();
+}
+
+expand_budget_error::expand_budget_error(size_t terms, size_t budget)
+  : std::runtime_error(expand_budget_message(terms, budget)),
+    nterms(terms), maxterms(budget)
+{
+}
+
+void set_expand_budget(size_t max_terms, size_t max_bytes)
+{
+	expand_term_budget.store(max_terms, std::memory_order_relaxed);
+	expand_byte_budget.store(max_bytes, std::memory_order_relaxed);
+}
+
+size_t expand_budget()
+{
+	size_t terms = expand_term_budget.load(std::memory_order_relaxed);
+	const size_t bytes = expand_byte_budget.load(std::memory_order_relaxed);
+	if (bytes != 0) {
+		const size_t by_bytes = std::max(bytes / expand_bytes_per_term, size_t(1));
+		if (terms == 0 or by_bytes < terms)
+			terms = by_bytes;
+	}
+	return terms;
+}
+
+void check_expand_budget(size_t terms)
+{
+	if (expand_term_budget.load(std::memory_order_relaxed) == 0
+	    and expand_byte_budget.load(std::memory_order_relaxed) == 0)
+		return;
+	const size_t budget = expand_budget();
+	if (terms > budget)
+		throw expand_budget_error(terms, budget);
 }
 
 /** Helper function for the ex-from-basic constructor. This is where GiNaC's
@@ -933,7 +1264,7 @@ ptr<basic> ex::construct_from_basic(const basic & other)
 		// no longer needed (it evaluated into something different), so we
 		// delete it (because nobody else will).
 		if ((other.get_refcount() == 0) && ((other.flags & status_flags::dynallocated) != 0u))
-			delete &other; // yes, you can apply delete to a const pointer
+			release_queue<basic>::release(const_cast<basic *>(&other));
 
 		// We can't return a basic& here because the tmpex is destroyed as
 		// soon as we leave the function, which would deallocate the
@@ -946,174 +1277,60 @@ ptr<basic> ex::construct_from_basic(const basic & other)
 
                 // The object is already heap-allocated, so we can just make
                 // another reference to it.
-                return ptr<basic>(const_cast<basic &>(other));
+                ptr<basic> p(const_cast<basic &>(other));
+                if (hash_consing)
+                        return intern(p);
+                return p;
         } 
 
+        // Small integers need not be copied at all.
+        if (is_exactly_a<numeric>(other)) {
+                const numeric & num = static_cast<const numeric &>(other);
+                if (num.is_long() and is_small_int(num.v._long))
+                        return ptr<basic>(*const_cast<numeric *>(small_int_flyweight(num.v._long)));
+        }
+
         // The object is not heap-allocated, so we create a duplicate
         // on the heap.
         basic *bp = other.duplicate();
         bp->setflag(status_flags::dynallocated);
         GINAC_ASSERT(bp->get_refcount() == 0);
+        if (hash_consing)
+                return intern(bp);
         return bp;
 }
 
 basic & ex::construct_from_int(int i)
 {
-	switch (i) {  // prefer flyweights over new objects
-	case -12:
-		return *const_cast<numeric *>(_num_12_p);
-	case -11:
-		return *const_cast<numeric *>(_num_11_p);
-	case -10:
-		return *const_cast<numeric *>(_num_10_p);
-	case -9:
-		return *const_cast<numeric *>(_num_9_p);
-	case -8:
-		return *const_cast<numeric *>(_num_8_p);
-	case -7:
-		return *const_cast<numeric *>(_num_7_p);
-	case -6:
-		return *const_cast<numeric *>(_num_6_p);
-	case -5:
-		return *const_cast<numeric *>(_num_5_p);
-	case -4:
-		return *const_cast<numeric *>(_num_4_p);
-	case -3:
-		return *const_cast<numeric *>(_num_3_p);
-	case -2:
-		return *const_cast<numeric *>(_num_2_p);
-	case -1:
-		return *const_cast<numeric *>(_num_1_p);
-	case 0:
-		return *const_cast<numeric *>(_num0_p);
-	case 1:
-		return *const_cast<numeric *>(_num1_p);
-	case 2:
-		return *const_cast<numeric *>(_num2_p);
-	case 3:
-		return *const_cast<numeric *>(_num3_p);
-	case 4:
-		return *const_cast<numeric *>(_num4_p);
-	case 5:
-		return *const_cast<numeric *>(_num5_p);
-	case 6:
-		return *const_cast<numeric *>(_num6_p);
-	case 7:
-		return *const_cast<numeric *>(_num7_p);
-	case 8:
-		return *const_cast<numeric *>(_num8_p);
-	case 9:
-		return *const_cast<numeric *>(_num9_p);
-	case 10:
-		return *const_cast<numeric *>(_num10_p);
-	case 11:
-		return *const_cast<numeric *>(_num11_p);
-	case 12:
-		return *const_cast<numeric *>(_num12_p);
-	default:
-		basic *bp = new numeric(i);
-		bp->setflag(status_flags::dynallocated);
-		GINAC_ASSERT(bp->get_refcount() == 0);
-		return *bp;
-	}
+	// prefer flyweights over new objects
+	if (is_small_int(i))
+		return *const_cast<numeric *>(small_int_flyweight(i));
+	basic *bp = new numeric(i);
+	bp->setflag(status_flags::dynallocated);
+	GINAC_ASSERT(bp->get_refcount() == 0);
+	return *bp;
 }
 	
 basic & ex::construct_from_uint(unsigned int i)
 {
-	switch (i) {  // prefer flyweights over new objects
-	case 0:
-		return *const_cast<numeric *>(_num0_p);
-	case 1:
-		return *const_cast<numeric *>(_num1_p);
-	case 2:
-		return *const_cast<numeric *>(_num2_p);
-	case 3:
-		return *const_cast<numeric *>(_num3_p);
-	case 4:
-		return *const_cast<numeric *>(_num4_p);
-	case 5:
-		return *const_cast<numeric *>(_num5_p);
-	case 6:
-		return *const_cast<numeric *>(_num6_p);
-	case 7:
-		return *const_cast<numeric *>(_num7_p);
-	case 8:
-		return *const_cast<numeric *>(_num8_p);
-	case 9:
-		return *const_cast<numeric *>(_num9_p);
-	case 10:
-		return *const_cast<numeric *>(_num10_p);
-	case 11:
-		return *const_cast<numeric *>(_num11_p);
-	case 12:
-		return *const_cast<numeric *>(_num12_p);
-	default:
-		basic *bp = new numeric(i);
-		bp->setflag(status_flags::dynallocated);
-		GINAC_ASSERT(bp->get_refcount() == 0);
-		return *bp;
-	}
+	// prefer flyweights over new objects
+	if (i <= static_cast<unsigned long>(small_int_max))
+		return *const_cast<numeric *>(small_int_flyweight(i));
+	basic *bp = new numeric(i);
+	bp->setflag(status_flags::dynallocated);
+	GINAC_ASSERT(bp->get_refcount() == 0);
+	return *bp;
 }
 	
 basic & ex::construct_from_long(long i)
 {
-	switch (i) {  // prefer flyweights over new objects
-	case -12:
-		return *const_cast<numeric *>(_num_12_p);
-	case -11:
-		return *const_cast<numeric *>(_num_11_p);
-	case -10:
-		return *const_cast<numeric *>(_num_10_p);
-	case -9:
-		return *const_cast<numeric *>(_num_9_p);
-	case -8:
-		return *const_cast<numeric *>(_num_8_p);
-	case -7:
-		return *const_cast<numeric *>(_num_7_p);
-	case -6:
-		return *const_cast<numeric *>(_num_6_p);
-	case -5:
-		return *const_cast<numeric *>(_num_5_p);
-	case -4:
-		return *const_cast<numeric *>(_num_4_p);
-	case -3:
-		return *const_cast<numeric *>(_num_3_p);
-	case -2:
-		return *const_cast<numeric *>(_num_2_p);
-	case -1:
-		return *const_cast<numeric *>(_num_1_p);
-	case 0:
-		return *const_cast<numeric *>(_num0_p);
-	case 1:
-		return *const_cast<numeric *>(_num1_p);
-	case 2:
-		return *const_cast<numeric *>(_num2_p);
-	case 3:
-		return *const_cast<numeric *>(_num3_p);
-	case 4:
-		return *const_cast<numeric *>(_num4_p);
-	case 5:
-		return *const_cast<numeric *>(_num5_p);
-	case 6:
-		return *const_cast<numeric *>(_num6_p);
-	case 7:
-		return *const_cast<numeric *>(_num7_p);
-	case 8:
-		return *const_cast<numeric *>(_num8_p);
-	case 9:
-		return *const_cast<numeric *>(_num9_p);
-	case 10:
-		return *const_cast<numeric *>(_num10_p);
-	case 11:
-		return *const_cast<numeric *>(_num11_p);
-	case 12:
-		return *const_cast<numeric *>(_num12_p);
-	default:
-		basic *bp = new numeric(i);
-		bp->setflag(status_flags::dynallocated);
-		GINAC_ASSERT(bp->get_refcount() == 0);
-		return *bp;
-	}
+	// prefer flyweights over new objects
+	if (is_small_int(i))
+		return *const_cast<numeric *>(small_int_flyweight(i));
+	basic *bp = new numeric(i);
+	bp->setflag(status_flags::dynallocated);
+	GINAC_ASSERT(bp->get_refcount() == 0);
+	return *bp;
 }
 	
 basic & ex::construct_from_double(double d)
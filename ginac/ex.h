@@ -27,9 +27,11 @@
 #include "ptr.h"
 #include "optional.hpp"
 
+#include <complex>
 #include <iosfwd>
 #include <iterator>
 #include <functional>
+#include <stdexcept>
 #include <stack>
 #include <unordered_set>
 
@@ -140,6 +142,8 @@ public:
 	ex eval(int level = 0) const { return bp->eval(level); }
 	ex evalf(int level = 0, PyObject* parent=nullptr) const 
 	{ return bp->evalf(level, parent); }
+	double evalf_double() const;
+	std::complex<double> evalf_cdouble() const;
 
 	// printing
 	void print(const print_context & c, unsigned level = 0) const;
@@ -169,7 +173,7 @@ public:
 	ex & let_op(size_t i);
 	ex & operator[](const ex & index);
 	ex & operator[](size_t i);
-        void set_epseq_from(size_t i, ex e) { bp->set_epseq_from(i, e); }
+        void set_epseq_from(size_t i, ex e) { makewriteable(); bp->set_epseq_from(i, e); }
 	ex lhs() const;
 	ex rhs() const;
 
@@ -215,6 +219,7 @@ public:
 
 	// expand/collect
 	ex expand(unsigned options=0) const;
+	size_t expand_size_estimate() const;
 	ex collect(const ex & s, bool distributed = false) const { return bp->collect(s, distributed); }
         ex collect_powers() const;
 
@@ -297,6 +302,45 @@ struct ex_hash {
     long operator()(const ex& e) const { return e.gethash(); }
 };
 
+/** Switch hash-consing on or off.  While it is on, every evaluated object
+ *  that gets wrapped into an ex is looked up in a table of unique objects
+ *  (keyed on gethash() and is_equal_same_type()), and an already existing
+ *  equal object is used instead of the new one.  Equal subexpressions then
+ *  share memory and usually compare equal by pointer.  Numerics and objects
+ *  flagged not_shareable are never entered into the table.  Switching it
+ *  off empties the table; this must not happen while other threads work
+ *  with expressions. */
+void set_hash_consing(bool enable);
+bool hash_consing_enabled();
+/** Number of objects currently in the hash-consing table. */
+size_t hash_consing_table_size();
+
+/** Exception thrown by expand() when a product or power of sums would
+ *  have more terms than allowed by set_expand_budget(). */
+class expand_budget_error : public std::runtime_error {
+public:
+	expand_budget_error(size_t terms, size_t budget);
+	/** Number of terms the expansion would have produced. */
+	size_t terms() const { return nterms; }
+	/** Number of terms that was allowed. */
+	size_t budget() const { return maxterms; }
+private:
+	size_t nterms, maxterms;
+};
+
+/** Limit the size of expansions.  Before expand() multiplies out a product
+ *  or power of sums it computes the number of resulting terms and throws
+ *  expand_budget_error if that exceeds max_terms, or if the estimated
+ *  memory for the terms exceeds max_bytes.  Zero means no limit, which is
+ *  the default. */
+void set_expand_budget(size_t max_terms, size_t max_bytes = 0);
+/** Maximal number of terms of one expansion step, taking both limits of
+ *  set_expand_budget() into account; zero if unlimited. */
+size_t expand_budget();
+/** Throw expand_budget_error if an expansion step producing the given
+ *  number of terms is over budget. */
+void check_expand_budget(size_t terms);
+
 
 // performance-critical inlined method implementations
 
@@ -34,21 +34,8 @@
 
 namespace GiNaC {
 
-/** Using hash tables can potentially enhance the asymptotic behaviour of
- *  combining n terms into one large sum (or n terms into one large product)
- *  from O(n*log(n)) to about O(n).  There are, however, several drawbacks.
- *  The constant in front of O(n) is quite large, when copying such an object
- *  one also has to copy the hash table, comparison is quite expensive because
- *  there is no ordering any more, it doesn't help at all when combining two
- *  expairseqs because due to the presorted nature the behaviour would be
- *  O(n) anyways, the code is quite messy, etc, etc.  The code is here as
- *  an example for following generations to tinker with. */
-#define EXPAIRSEQ_USE_HASHTAB 0
-
 typedef std::vector<expair> epvector;       ///< expair-vector
 typedef epvector::iterator epp;             ///< expair-vector pointer
-typedef std::list<epp> epplist;             ///< list of expair-vector pointers
-typedef std::vector<epplist> epplistvector; ///< vector of epplist
 
 /** Complex conjugate every element of an epvector. Returns zero if this
  *  does not change anything. */
@@ -69,6 +56,8 @@ class expairseq : public basic
 
 	friend class print_order;
         friend class ex;
+	friend class expairseq_accumulator;
+	friend class sparse_poly;
 	// other constructors
 public:
 	expairseq(const ex & lh, const ex & rh);
@@ -85,6 +74,8 @@ public:
 	virtual ex stable_op(size_t i) const;
         void set_pair_from(size_t i, ex e) { seq[i] = split_ex_to_pair(e); }
 	const numeric & get_overall_coeff() const { return overall_coeff; }
+	/** The pairs in storage order, without sorting them first. */
+	const epvector & get_seq() const { return seq; }
 	ex map(map_function & f) const override;
 	ex eval(int level=0) const override;
 	ex to_rational(exmap & repl) const override;
@@ -94,6 +85,13 @@ public:
 	ex conjugate() const override;
 	numeric calc_total_degree() const;
 	virtual const epvector & get_sorted_seq() const;
+
+	/** Sequences with at least this many terms are combined using a hash
+	 *  table instead of sorting first. */
+	static size_t hash_combine_threshold;
+	/** Sequences with at least this many terms are sorted using several
+	 *  threads, see set_parallel_threads(). */
+	static size_t parallel_sort_threshold;
 protected:
 	bool is_equal_same_type(const basic & other) const override;
 	unsigned return_type() const override;
@@ -136,29 +134,11 @@ protected:
 	void make_flat(const exvector & v, bool hold=false);
 	void make_flat(const epvector & v, bool do_index_renaming = false);
 	void canonicalize();
+	bool canonicalize_parallel();
 	void combine_same_terms_sorted_seq();
         bool overall_coeff_equals_default() const;
-#if EXPAIRSEQ_USE_HASHTAB
 	void combine_same_terms();
-	unsigned calc_hashtabsize(unsigned sz) const;
-	unsigned calc_hashindex(const ex & e) const;
-	void shrink_hashtab();
-	void remove_hashtab_entry(epvector::const_iterator element);
-	void move_hashtab_entry(epvector::const_iterator oldpos,
-	                        epvector::iterator newpos);
-	void sorted_insert(epplist & eppl, epvector::const_iterator elem);
-	void build_hashtab_and_combine(epvector::iterator & first_numeric,
-	                               epvector::iterator & last_non_zero,
-	                               vector<bool> & touched,
-	                               unsigned & number_of_zeroes);
-	void drop_coeff_0_terms(epvector::iterator & first_numeric,
-	                        epvector::iterator & last_non_zero,
-	                        vector<bool> & touched,
-	                        unsigned & number_of_zeroes);
-	bool has_coeff_0() const;
-	void add_numerics_to_hashtab(epvector::iterator first_numeric,
-	                             epvector::const_iterator last_non_zero);
-#endif // EXPAIRSEQ_USE_HASHTAB
+	void combine_same_terms_hashed();
 	bool is_canonical() const;
 	std::unique_ptr<epvector> expandchildren(unsigned options) const;
 	std::unique_ptr<epvector> evalchildren(int level) const;
@@ -170,14 +150,6 @@ protected:
 	epvector seq;
 	mutable epvector seq_sorted;
 	numeric overall_coeff;
-#if EXPAIRSEQ_USE_HASHTAB
-	epplistvector hashtab;
-	unsigned hashtabsize;
-	unsigned hashmask;
-	static unsigned maxhashtabsize;
-	static unsigned minhashtabsize;
-	static unsigned hashtabfactor;
-#endif // EXPAIRSEQ_USE_HASHTAB
 };
 
 /** Class to handle the renaming of dummy indices. It holds a vector of
@@ -252,8 +252,8 @@ long fderivative::calchash() const
 
 	res=h^res;
 	if (is_evaluated()) {
-		setflag(status_flags::hash_calculated);
 		hashvalue = res;
+		setflag(status_flags::hash_calculated);
 	}
 	return res;
 }
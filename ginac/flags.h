@@ -42,7 +42,8 @@ public:
 		expand_function_args = 0x0002, ///< expands the arguments of functions
 		expand_rename_idx = 0x0004, ///< no longer used 
 		expand_transcendental = 0x0008, ///< expands trancendental functions like log and exp
-		expand_only_numerators = 0x0010 ///< does not expand fraction denominators
+		expand_only_numerators = 0x0010, ///< does not expand fraction denominators
+		expand_shared = 0x0020 ///< expands subexpressions occurring several times only once
 	};
 };
 
@@ -219,6 +220,7 @@ public:
 		is_positive	= 0x0080,
 		is_negative	= 0x0100,
 		purely_indefinite = 0x0200,  // If set in a mul, then it does not contains any terms with determined signs, used in power::expand()
+		interned        = 0x0400, ///< object is the canonical instance in the hash-consing table (@see set_hash_consing())
  		tdegree_calculated	= 0x0080  // .total_degree() has already
 						  // done its job (for mul)
 	};
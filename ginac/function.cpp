@@ -1018,8 +1018,8 @@ long function::calchash() const
 	}
 
 	if (is_evaluated()) {
-		setflag(status_flags::hash_calculated);
 		hashvalue = v;
+		setflag(status_flags::hash_calculated);
 	}
 	return v;
 }
@@ -28,6 +28,7 @@
 #include "basic.h"
 
 #include "ex.h"
+#include "arena.h"
 #include "normal.h"
 #include "archive.h"
 #include "print.h"
@@ -47,8 +48,14 @@
 #include "expairseq.h"
 #include "add.h"
 #include "mul.h"
+#include "accumulator.h"
 #include "upoly.h"
 #include "mpoly.h"
+#include "sparse_poly.h"
+#include "evalf_ball.h"
+#include "compiled_ex.h"
+#include "cse.h"
+#include "csrc.h"
 
 #include "exprseq.h"
 #include "function.h"
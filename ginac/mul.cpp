@@ -34,6 +34,7 @@
 #include "inifcns.h"
 #include "order.h"
 #include "mpoly.h"
+#include "sparse_poly.h"
 
 #include <iostream>
 #include <vector>
@@ -1245,7 +1246,7 @@ numeric mul::default_overall_coeff() const
 
 void mul::combine_overall_coeff(const numeric & c)
 {
-	overall_coeff *= c;
+	overall_coeff.mul_by(c);
 }
 
 void mul::combine_overall_coeff(const numeric & c1, const numeric & c2)
@@ -1253,7 +1254,7 @@ void mul::combine_overall_coeff(const numeric & c1, const numeric & c2)
 	ex e = c1.power(c2);
 	if (not is_exactly_a<numeric>(e))
                 throw std::runtime_error("mul::combine_overall_coeff: can't happen");
-	overall_coeff *= ex_to<numeric>(e);
+	overall_coeff.mul_by(ex_to<numeric>(e));
 }
 
 bool mul::can_make_flat(const expair & p) const
@@ -1278,6 +1279,9 @@ bool mul::can_be_further_expanded(const ex & e)
 	return false;
 }
 
+// Products of sums with fewer term products are multiplied out directly.
+static const size_t sparse_poly_min_products = 64;
+
 ex mul::expand(unsigned options) const
 {
 	// trivial case: expanding the monomial (~ 30% of all calls)
@@ -1310,6 +1314,20 @@ ex mul::expand(unsigned options) const
 		if (is_exactly_a<add>(elem.rest) &&
 			(elem.coeff.is_one())) {
 			if (is_exactly_a<add>(last_expanded)) {
+				check_expand_budget(last_expanded.nops() * elem.rest.nops());
+
+				// Polynomials are multiplied much faster in a
+				// dedicated representation.
+				if (ex_to<add>(last_expanded).seq.size() * ex_to<add>(elem.rest).seq.size()
+				    >= sparse_poly_min_products) {
+					ex prod;
+					if (sparse_poly::expand_product(ex_to<add>(last_expanded),
+					                                ex_to<add>(elem.rest), prod)) {
+						last_expanded = prod;
+						continue;
+					}
+				}
+
 				// Expand a product of two sums, aggressive version.
 				// Caring for the overall coefficients in separate loops can
 				// sometimes give a performance gain of up to 15%!
@@ -57,9 +57,11 @@
 #include "flint/fmpz_factor.h"
 
 #include <cmath>
+#include <map>
 #include <utility>
 
 #include "numeric.h"
+#include "ball.h"
 #include "operators.h"
 #include "ex.h"
 #include "mul.h"
@@ -193,6 +195,33 @@ inline void py_error(const char* errmsg) {
 // than what we can do without those. 
 static bool initialized = false;
 
+// The Sage element given to ginac_pyinit_I.  Gaussian rationals of its
+// type are stored natively, and converted back using it.
+static PyObject* pyobject_I = nullptr;
+
+// Whether o lies in the parent of Sage's I.  Other Gaussian fields share
+// its Python type, but mpqc_to_pyobject() would map their elements to the
+// parent of I.
+static bool is_Gaussian_rational(PyObject* o)
+{
+        if (pyobject_I == nullptr or Py_TYPE(o) != Py_TYPE(pyobject_I))
+                return false;
+        static PyObject* parent_I = nullptr;
+        if (parent_I == nullptr) {
+                parent_I = PyObject_CallMethod(pyobject_I,
+                                const_cast<char*>("parent"), NULL);
+                if (parent_I == nullptr)
+                        py_error("Error getting parent of I");
+        }
+        PyObject* parent = PyObject_CallMethod(o,
+                        const_cast<char*>("parent"), NULL);
+        if (parent == nullptr)
+                py_error("Error getting parent attribute");
+        bool same = parent == parent_I;
+        Py_DECREF(parent);
+        return same;
+}
+
 static PyObject* pyfunc_Float = nullptr;
 
 void ginac_pyinit_Float(PyObject* f) {
@@ -203,6 +232,8 @@ void ginac_pyinit_Float(PyObject* f) {
 void ginac_pyinit_I(PyObject* z) {
         initialized = true;
         Py_INCREF(z);
+        pyobject_I = z;
+        Py_INCREF(z);
         GiNaC::I = z; // I is a global constant defined below.
 }
 
@@ -505,6 +536,15 @@ PyObject* ONE = PyLong_FromLong(1); // todo: never freed
 PyObject* TWO = PyLong_FromLong(2); // todo: never freed
 #endif
 
+static void mpfc_init2(mpfc_ptr& z, mpfr_prec_t prec);
+static void mpfc_clear(mpfc_ptr z);
+static inline mpfr_prec_t mpfc_get_prec(mpfc_srcptr z);
+static void mpfc_set_numeric(mpfc_ptr z, const numeric& x);
+static void mpqc_init(mpqc_ptr& z);
+static void mpqc_clear(mpqc_ptr z);
+static void mpqc_set(mpqc_ptr z, mpqc_srcptr x);
+static void ball_set(ball_ptr b, ball_srcptr x);
+
 std::ostream& operator<<(std::ostream& os, const numeric& s) {
         switch (s.t) {
         case LONG:
@@ -521,6 +561,53 @@ std::ostream& operator<<(std::ostream& os, const numeric& s) {
                 mpq_get_str(&cp[0], 10, s.v._bigrat);
                 return os << &cp[0];
         }
+        case MPFR: {
+                // as many digits as Sage prints
+                int digits = static_cast<int>(mpfr_get_prec(s.v._bigfloat) * 0.30103);
+                char *str;
+                mpfr_asprintf(&str, "%.*Rg", std::max(digits, 1), s.v._bigfloat);
+                os << str;
+                mpfr_free_str(str);
+                return os;
+        }
+        case MPFC: {
+                int digits = static_cast<int>(mpfc_get_prec(s.v._bigcomplex) * 0.30103);
+                char *str;
+                mpfr_asprintf(&str, "%.*Rg%+.*Rg*I", std::max(digits, 1),
+                                s.v._bigcomplex->re, std::max(digits, 1),
+                                s.v._bigcomplex->im);
+                os << str;
+                mpfr_free_str(str);
+                return os;
+        }
+        case MPQC: {
+                mpq_srcptr re = s.v._gaussrat->re, im = s.v._gaussrat->im;
+                size_t size = std::max(mpz_sizeinbase(mpq_numref(re), 10)
+                                + mpz_sizeinbase(mpq_denref(re), 10),
+                                mpz_sizeinbase(mpq_numref(im), 10)
+                                + mpz_sizeinbase(mpq_denref(im), 10)) + 5;
+                std::vector<char> cp(size);
+                if (mpq_sgn(re) != 0) {
+                        mpq_get_str(&cp[0], 10, re);
+                        os << &cp[0];
+                        if (mpq_sgn(im) > 0)
+                                os << '+';
+                }
+                mpq_get_str(&cp[0], 10, im);
+                return os << &cp[0] << "*I";
+        }
+        case ACB: {
+                slong digits = std::max<slong>(s.v._ball->prec * 0.30103, 1);
+                char *str = arb_get_str(acb_realref(&s.v._ball->z), digits, 0);
+                os << str;
+                flint_free(str);
+                if (acb_is_real(&s.v._ball->z) == 0) {
+                        str = arb_get_str(acb_imagref(&s.v._ball->z), digits, 0);
+                        os << " + (" << str << ")*I";
+                        flint_free(str);
+                }
+                return os;
+        }
         case PYOBJECT:
                 return os << *py_funcs.py_repr(s.v._pyobject, 0);
         default:
@@ -538,6 +625,18 @@ const numeric& numeric::operator=(const numeric& x) {
         case MPQ:
                 mpq_clear(v._bigrat);
                 break;
+        case MPFR:
+                mpfr_clear(v._bigfloat);
+                break;
+        case MPFC:
+                mpfc_clear(v._bigcomplex);
+                break;
+        case MPQC:
+                mpqc_clear(v._gaussrat);
+                break;
+        case ACB:
+                ball_clear(v._ball);
+                break;
         case PYOBJECT:
                 Py_DECREF(v._pyobject);
                 break;
@@ -556,6 +655,22 @@ const numeric& numeric::operator=(const numeric& x) {
                 mpq_init(v._bigrat);
                 mpq_set(v._bigrat, x.v._bigrat);
                 break;
+        case MPFR:
+                mpfr_init2(v._bigfloat, mpfr_get_prec(x.v._bigfloat));
+                mpfr_set(v._bigfloat, x.v._bigfloat, MPFR_RNDN);
+                break;
+        case MPFC:
+                mpfc_init2(v._bigcomplex, mpfc_get_prec(x.v._bigcomplex));
+                mpfc_set_numeric(v._bigcomplex, x);
+                break;
+        case MPQC:
+                mpqc_init(v._gaussrat);
+                mpqc_set(v._gaussrat, x.v._gaussrat);
+                break;
+        case ACB:
+                ball_init(v._ball, x.v._ball->prec);
+                ball_set(v._ball, x.v._ball);
+                break;
         case PYOBJECT:
                 v = x.v;
                 Py_INCREF(v._pyobject);
@@ -594,6 +709,24 @@ int numeric::compare_same_type(const numeric& right) const {
                 else if (t == MPQ and right.t == LONG) {
                         ret = mpq_cmp_si(v._bigrat, right.v._long, 1);
                 }
+                else if (t == MPFR and right.t == LONG) {
+                        ret = mpfr_cmp_si(v._bigfloat, right.v._long);
+                }
+                else if (t == MPFR and right.t == MPZ) {
+                        ret = mpfr_cmp_z(v._bigfloat, right.v._bigint);
+                }
+                else if (t == MPFR and right.t == MPQ) {
+                        ret = mpfr_cmp_q(v._bigfloat, right.v._bigrat);
+                }
+                else if (t == LONG and right.t == MPFR) {
+                        ret = -mpfr_cmp_si(right.v._bigfloat, v._long);
+                }
+                else if (t == MPZ and right.t == MPFR) {
+                        ret = -mpfr_cmp_z(right.v._bigfloat, v._bigint);
+                }
+                else if (t == MPQ and right.t == MPFR) {
+                        ret = -mpfr_cmp_q(right.v._bigfloat, v._bigrat);
+                }
                 else {
                         numeric a, b;
                         coerce(a, b, *this, right);
@@ -628,6 +761,53 @@ int numeric::compare_same_type(const numeric& right) const {
                 else if (ret < 0)
                         ret = -1;
                 return ret;
+        case MPFR:
+                ret = mpfr_cmp(v._bigfloat, right.v._bigfloat);
+                if (ret > 0)
+                        ret = 1;
+                else if (ret < 0)
+                        ret = -1;
+                return ret;
+        case MPFC:
+                // real parts first, then imaginary parts
+                ret = mpfr_cmp(v._bigcomplex->re, right.v._bigcomplex->re);
+                if (ret == 0)
+                        ret = mpfr_cmp(v._bigcomplex->im,
+                                        right.v._bigcomplex->im);
+                if (ret > 0)
+                        ret = 1;
+                else if (ret < 0)
+                        ret = -1;
+                return ret;
+        case MPQC:
+                ret = mpq_cmp(v._gaussrat->re, right.v._gaussrat->re);
+                if (ret == 0)
+                        ret = mpq_cmp(v._gaussrat->im, right.v._gaussrat->im);
+                if (ret > 0)
+                        ret = 1;
+                else if (ret < 0)
+                        ret = -1;
+                return ret;
+        case ACB: {
+                // midpoints first, then radii
+                acb_srcptr a = &v._ball->z, b = &right.v._ball->z;
+                ret = arf_cmp(arb_midref(acb_realref(a)),
+                                arb_midref(acb_realref(b)));
+                if (ret == 0)
+                        ret = arf_cmp(arb_midref(acb_imagref(a)),
+                                        arb_midref(acb_imagref(b)));
+                if (ret == 0)
+                        ret = mag_cmp(arb_radref(acb_realref(a)),
+                                        arb_radref(acb_realref(b)));
+                if (ret == 0)
+                        ret = mag_cmp(arb_radref(acb_imagref(a)),
+                                        arb_radref(acb_imagref(b)));
+                if (ret > 0)
+                        ret = 1;
+                else if (ret < 0)
+                        ret = -1;
+                return ret;
+        }
         case PYOBJECT: {
                 int result = PyObject_RichCompareBool(v._pyobject,
                 right.v._pyobject, Py_LT);
@@ -659,7 +839,7 @@ int numeric::compare_same_type(const numeric& right) const {
    with their Python hashes, this applies to our MPZ
    and MPQ objects too. This implementation is copied
    from sage.libs.gmp.pylong.mpz_pythonhash. */
-static long _mpz_pythonhash_raw(mpz_t the_int)
+static long _mpz_pythonhash_raw(mpz_srcptr the_int)
 {
     if (mpz_sgn(the_int) == 0)
         return 0;
@@ -694,7 +874,7 @@ static long _mpz_pythonhash_raw(mpz_t the_int)
     return h;
 }
 
-static long _mpz_pythonhash(mpz_t the_int)
+static long _mpz_pythonhash(mpz_srcptr the_int)
 {
     long h = _mpz_pythonhash_raw(the_int);
     if (h == -1)
@@ -702,21 +882,89 @@ static long _mpz_pythonhash(mpz_t the_int)
     return h;
 }
 
-static long _mpq_pythonhash(mpq_t the_rat)
+static long _mpq_pythonhash(mpq_srcptr the_rat)
 {
-    mpq_t rat;
-    mpq_init(rat);
-    mpq_set(rat, the_rat);
-    long n = _mpz_pythonhash_raw(mpq_numref(rat));
-    long d = _mpz_pythonhash_raw(mpq_denref(rat));
+    long n = _mpz_pythonhash_raw(mpq_numref(the_rat));
+    long d = _mpz_pythonhash_raw(mpq_denref(the_rat));
     if (d != 1L)
         n = n + (d-1) * 7461864723258187525;
-    mpq_clear(rat);
     if (n == -1)
         return -2;
     return n;
 }
 
+/* Sage hashes real numbers as the Python float closest to them, so
+   this follows the algorithm of Python's float hash. */
+static long _mpfr_pythonhash(mpfr_t the_float)
+{
+    if (mpfr_nan_p(the_float))
+        return 0;
+    if (mpfr_inf_p(the_float))
+        return mpfr_sgn(the_float) > 0 ? 314159 : -314159;
+
+    // values outside the double range hash as float(x), which is inf
+    double d = mpfr_get_d(the_float, MPFR_RNDN);
+    if (std::isinf(d))
+        return d > 0 ? 314159 : -314159;
+
+    mp_limb_t modulus = ((((mp_limb_t)(1) << (hash_bits - 1)) - 1) * 2) + 1;
+    int e;
+    double m = std::frexp(d, &e);
+    int sign = 1;
+    if (m < 0) {
+        sign = -1;
+        m = -m;
+    }
+    mp_limb_t x = 0, y;
+    while (m != 0.0) {
+        x = ((x << 28) & modulus) | x >> (hash_bits - 28);
+        m *= 268435456.0;  // 2**28
+        e -= 28;
+        y = (mp_limb_t)m;
+        m -= y;
+        x += y;
+        if (x >= modulus)
+            x -= modulus;
+    }
+    e = e >= 0 ? e % hash_bits : hash_bits - 1 - ((-1 - e) % hash_bits);
+    x = ((x << e) & modulus) | x >> (hash_bits - e);
+    long h = sign * (long)x;
+    if (h == -1)
+        return -2;
+    return h;
+}
+
+
+/* Python reduces integers modulo 2**hash_bits - 1, so a long at or
+   beyond the modulus does not hash to itself. */
+static long _long_pythonhash(long x)
+{
+    if (hash_bits < 8 * sizeof(long)) {
+        const unsigned long modulus
+                = ((((unsigned long)(1) << (hash_bits - 1)) - 1) * 2) + 1;
+        unsigned long a = x < 0 ? -static_cast<unsigned long>(x) : x;
+        if (a >= modulus) {
+            a %= modulus;
+            x = x < 0 ? -static_cast<long>(a) : static_cast<long>(a);
+        }
+    }
+    if (x == -1)
+        return -2;
+    return x;
+}
+
+/* The hash of an MPZ, MPQ or MPQC is computed from the limbs by
+   calchash() when it is first needed, so arithmetic does not pay for
+   the hashes of intermediate results.  No Python hash is -1.
+   With thread-safe reference counting several threads may hash the same
+   number at once, so the hash is then recomputed instead of cached. */
+static const long hash_pending = -1;
+
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+#define CACHED_HASH(h, f)  ((h) == hash_pending ? (f) : (h))
+#else
+#define CACHED_HASH(h, f)  ((h) == hash_pending ? ((h) = (f)) : (h))
+#endif
 
 // Initialize an mpz_t from a Python long integer
 static void _mpz_set_pylong(mpz_t z, PyLongObject* l)
@@ -736,6 +984,625 @@ static void _mpz_set_pylong(mpz_t z, PyLongObject* l)
         mpz_neg(z, z);
 }
 
+//////////
+// MPFR floats
+//////////
+
+// Precision of the floats produced by evalf() without parent, 0 if the
+// result should come from Sage's RR.
+static long evalf_mpfr_prec = 0;
+
+void set_evalf_mpfr_precision(long prec)
+{
+        if (prec < 0 or (prec > 0 and prec < MPFR_PREC_MIN) or prec > MPFR_PREC_MAX)
+                throw std::invalid_argument("set_evalf_mpfr_precision(): invalid precision");
+        evalf_mpfr_prec = prec;
+}
+
+long evalf_mpfr_precision()
+{
+        return evalf_mpfr_prec;
+}
+
+// The result of an operation on two floats gets the lower one of their
+// precisions, as in Sage.
+static inline mpfr_prec_t mpfr_common_prec(mpfr_srcptr a, mpfr_srcptr b)
+{
+        return std::min(mpfr_get_prec(a), mpfr_get_prec(b));
+}
+
+// Round a float or an exact rational to the precision of f.
+static void mpfr_set_numeric(mpfr_ptr f, const numeric& x)
+{
+        switch (x.t) {
+        case LONG:
+                mpfr_set_si(f, x.v._long, MPFR_RNDN);
+                return;
+        case MPZ:
+                mpfr_set_z(f, x.v._bigint, MPFR_RNDN);
+                return;
+        case MPQ:
+                mpfr_set_q(f, x.v._bigrat, MPFR_RNDN);
+                return;
+        case MPFR:
+                mpfr_set(f, x.v._bigfloat, MPFR_RNDN);
+                return;
+        default:
+                stub("mpfr_set_numeric: type not handled");
+        }
+}
+
+typedef int (*mpfr_func1)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t);
+typedef int (*mpfr_func2)(mpfr_ptr, mpfr_srcptr, mpfr_srcptr, mpfr_rnd_t);
+
+static numeric mpfr_apply(mpfr_func1 f, mpfr_srcptr a)
+{
+        mpfr_t bigfloat;
+        mpfr_init2(bigfloat, mpfr_get_prec(a));
+        f(bigfloat, a, MPFR_RNDN);
+        return bigfloat;
+}
+
+static numeric mpfr_apply(mpfr_func2 f, mpfr_srcptr a, mpfr_srcptr b)
+{
+        mpfr_t bigfloat;
+        mpfr_init2(bigfloat, mpfr_common_prec(a, b));
+        f(bigfloat, a, b, MPFR_RNDN);
+        return bigfloat;
+}
+
+// Sage's RealField or ComplexField of the given precision, cached.
+// Returns a BORROWED REFERENCE.
+static PyObject* sage_field_get(const char* name, mpfr_prec_t prec)
+{
+        static std::map<std::pair<std::string, mpfr_prec_t>, PyObject*> fields;
+        auto key = std::make_pair(std::string(name), prec);
+        auto it = fields.find(key);
+        if (it != fields.end())
+                return it->second;
+        PyObject* m = PyImport_ImportModule("sage.rings.all");
+        if (m == nullptr)
+                py_error("Error importing sage.rings.all");
+        PyObject* f = PyObject_GetAttrString(m, name);
+        if (f == nullptr)
+                py_error("Error getting field attribute");
+        PyObject* field = PyObject_CallFunction(f, const_cast<char*>("l"),
+                                                static_cast<long>(prec));
+        if (field == nullptr)
+                py_error("Error creating field");
+        Py_DECREF(f);
+        Py_DECREF(m);
+        fields.emplace(key, field);
+        return field;
+}
+
+// Convert a float to an element of Sage's RealField of the same precision.
+// Returns a NEW REFERENCE.
+static PyObject* mpfr_to_pyobject(mpfr_srcptr f)
+{
+        PyObject* field = sage_field_get("RealField", mpfr_get_prec(f));
+        PyObject* ret;
+        if (mpfr_number_p(f) == 0) {
+                const char* s = mpfr_nan_p(f) != 0 ? "NaN"
+                        : (mpfr_sgn(f) > 0 ? "+infinity" : "-infinity");
+                ret = PyObject_CallFunction(field, const_cast<char*>("s"), s);
+        }
+        else {
+                // f is exactly m*2^e
+                mpz_t m;
+                mpz_init(m);
+                mpfr_exp_t e = mpfr_get_z_2exp(m, f);
+                mpq_t bigrat;
+                mpq_init(bigrat);
+                mpq_set_z(bigrat, m);
+                if (e >= 0)
+                        mpq_mul_2exp(bigrat, bigrat, e);
+                else
+                        mpq_div_2exp(bigrat, bigrat, -e);
+                PyObject* rat = py_funcs.py_rational_from_mpq(bigrat);
+                mpq_clear(bigrat);
+                mpz_clear(m);
+                ret = PyObject_CallFunctionObjArgs(field, rat, NULL);
+                Py_DECREF(rat);
+        }
+        if (ret == nullptr)
+                py_error("Error converting MPFR float to RealNumber");
+        return ret;
+}
+
+//////////
+// Complex numbers
+//////////
+
+// Complex numbers are allocated separately, so that they do not make
+// every numeric larger.  mpfc_clear() frees what mpfc_init2() allocates.
+static void mpfc_init2(mpfc_ptr& z, mpfr_prec_t prec)
+{
+        z = new mpfc_struct;
+        mpfr_init2(z->re, prec);
+        mpfr_init2(z->im, prec);
+}
+
+static void mpfc_clear(mpfc_ptr z)
+{
+        mpfr_clear(z->re);
+        mpfr_clear(z->im);
+        delete z;
+}
+
+static inline mpfr_prec_t mpfc_get_prec(mpfc_srcptr z)
+{
+        return mpfr_get_prec(z->re);
+}
+
+// Precision of a real or complex float, MPFR_PREC_MAX for other numbers.
+static mpfr_prec_t float_prec(const numeric& x)
+{
+        if (x.t == MPFR)
+                return mpfr_get_prec(x.v._bigfloat);
+        if (x.t == MPFC)
+                return mpfc_get_prec(x.v._bigcomplex);
+        return MPFR_PREC_MAX;
+}
+
+static void mpqc_init(mpqc_ptr& z)
+{
+        z = new mpqc_struct;
+        mpq_init(z->re);
+        mpq_init(z->im);
+}
+
+static void mpqc_clear(mpqc_ptr z)
+{
+        mpq_clear(z->re);
+        mpq_clear(z->im);
+        delete z;
+}
+
+static void mpqc_set(mpqc_ptr z, mpqc_srcptr x)
+{
+        mpq_set(z->re, x->re);
+        mpq_set(z->im, x->im);
+}
+
+// Set z to an exact real or Gaussian rational.
+static void mpqc_set_numeric(mpqc_ptr z, const numeric& x)
+{
+        switch (x.t) {
+        case LONG:
+                mpq_set_si(z->re, x.v._long, 1);
+                mpq_set_ui(z->im, 0, 1);
+                return;
+        case MPZ:
+                mpq_set_z(z->re, x.v._bigint);
+                mpq_set_ui(z->im, 0, 1);
+                return;
+        case MPQ:
+                mpq_set(z->re, x.v._bigrat);
+                mpq_set_ui(z->im, 0, 1);
+                return;
+        case MPQC:
+                mpqc_set(z, x.v._gaussrat);
+                return;
+        default:
+                stub("mpqc_set_numeric: type not handled");
+        }
+}
+
+// Round any native number to the precision of z.
+static void mpfc_set_numeric(mpfc_ptr z, const numeric& x)
+{
+        switch (x.t) {
+        case LONG:
+        case MPZ:
+        case MPQ:
+        case MPFR:
+                mpfr_set_numeric(z->re, x);
+                mpfr_set_zero(z->im, 1);
+                return;
+        case MPQC:
+                mpfr_set_q(z->re, x.v._gaussrat->re, MPFR_RNDN);
+                mpfr_set_q(z->im, x.v._gaussrat->im, MPFR_RNDN);
+                return;
+        case MPFC:
+                mpfr_set(z->re, x.v._bigcomplex->re, MPFR_RNDN);
+                mpfr_set(z->im, x.v._bigcomplex->im, MPFR_RNDN);
+                return;
+        default:
+                stub("mpfc_set_numeric: type not handled");
+        }
+}
+
+// The arithmetic functions allow the result to be one of the operands.
+
+static void mpqc_add(mpqc_ptr r, mpqc_srcptr a, mpqc_srcptr b)
+{
+        mpq_add(r->re, a->re, b->re);
+        mpq_add(r->im, a->im, b->im);
+}
+
+static void mpqc_sub(mpqc_ptr r, mpqc_srcptr a, mpqc_srcptr b)
+{
+        mpq_sub(r->re, a->re, b->re);
+        mpq_sub(r->im, a->im, b->im);
+}
+
+static void mpqc_mul(mpqc_ptr r, mpqc_srcptr a, mpqc_srcptr b)
+{
+        mpq_t re, tmp;
+        mpq_init(re);
+        mpq_init(tmp);
+        mpq_mul(re, a->re, b->re);
+        mpq_mul(tmp, a->im, b->im);
+        mpq_sub(re, re, tmp);
+        mpq_mul(tmp, a->re, b->im);
+        mpq_mul(r->im, a->im, b->re);
+        mpq_add(r->im, r->im, tmp);
+        mpq_swap(r->re, re);
+        mpq_clear(re);
+        mpq_clear(tmp);
+}
+
+// (a+bi)/(c+di) = ((ac+bd) + (bc-ad)i) / (c^2+d^2)
+static void mpqc_div(mpqc_ptr r, mpqc_srcptr a, mpqc_srcptr b)
+{
+        mpq_t den, re, tmp;
+        mpq_init(den);
+        mpq_init(re);
+        mpq_init(tmp);
+        mpq_mul(den, b->re, b->re);
+        mpq_mul(tmp, b->im, b->im);
+        mpq_add(den, den, tmp);
+        mpq_mul(re, a->re, b->re);
+        mpq_mul(tmp, a->im, b->im);
+        mpq_add(re, re, tmp);
+        mpq_mul(tmp, a->re, b->im);
+        mpq_mul(r->im, a->im, b->re);
+        mpq_sub(r->im, r->im, tmp);
+        mpq_div(r->re, re, den);
+        mpq_div(r->im, r->im, den);
+        mpq_clear(den);
+        mpq_clear(re);
+        mpq_clear(tmp);
+}
+
+static void mpfc_add(mpfc_ptr r, mpfc_srcptr a, mpfc_srcptr b)
+{
+        mpfr_add(r->re, a->re, b->re, MPFR_RNDN);
+        mpfr_add(r->im, a->im, b->im, MPFR_RNDN);
+}
+
+static void mpfc_sub(mpfc_ptr r, mpfc_srcptr a, mpfc_srcptr b)
+{
+        mpfr_sub(r->re, a->re, b->re, MPFR_RNDN);
+        mpfr_sub(r->im, a->im, b->im, MPFR_RNDN);
+}
+
+// Each part is rounded once, using fused multiply-add.
+static void mpfc_mul(mpfc_ptr r, mpfc_srcptr a, mpfc_srcptr b)
+{
+        mpfr_t re;
+        mpfr_init2(re, mpfr_get_prec(r->re));
+        mpfr_fmms(re, a->re, b->re, a->im, b->im, MPFR_RNDN);
+        mpfr_fmma(r->im, a->re, b->im, a->im, b->re, MPFR_RNDN);
+        mpfr_swap(r->re, re);
+        mpfr_clear(re);
+}
+
+// (a+bi)/(c+di) = ((ac+bd) + (bc-ad)i) / (c^2+d^2), the intermediate
+// results carrying some guard bits.
+static void mpfc_div(mpfc_ptr r, mpfc_srcptr a, mpfc_srcptr b)
+{
+        mpfr_prec_t prec = mpfr_get_prec(r->re) + 32;
+        mpfr_t den, re, im;
+        mpfr_init2(den, prec);
+        mpfr_init2(re, prec);
+        mpfr_init2(im, prec);
+        mpfr_fmma(den, b->re, b->re, b->im, b->im, MPFR_RNDN);
+        mpfr_fmma(re, a->re, b->re, a->im, b->im, MPFR_RNDN);
+        mpfr_fmms(im, a->im, b->re, a->re, b->im, MPFR_RNDN);
+        mpfr_div(r->re, re, den, MPFR_RNDN);
+        mpfr_div(r->im, im, den, MPFR_RNDN);
+        mpfr_clear(den);
+        mpfr_clear(re);
+        mpfr_clear(im);
+}
+
+// z^n, or 1/z^-n for negative n, by repeated squaring
+static void mpqc_pow_si(mpqc_ptr r, mpqc_srcptr z, long n)
+{
+        unsigned long e = n < 0 ? -static_cast<unsigned long>(n) : n;
+        mpqc_ptr base;
+        mpqc_init(base);
+        mpqc_set(base, z);
+        mpqc_ptr acc;
+        mpqc_init(acc);
+        mpq_set_ui(acc->re, 1, 1);
+        while (e != 0) {
+                if ((e & 1) != 0)
+                        mpqc_mul(acc, acc, base);
+                e >>= 1;
+                if (e != 0)
+                        mpqc_mul(base, base, base);
+        }
+        if (n < 0) {
+                mpq_set_ui(base->re, 1, 1);
+                mpq_set_ui(base->im, 0, 1);
+                mpqc_div(r, base, acc);
+        }
+        else
+                mpqc_set(r, acc);
+        mpqc_clear(base);
+        mpqc_clear(acc);
+}
+
+static void mpfc_pow_si(mpfc_ptr r, mpfc_srcptr z, long n)
+{
+        unsigned long e = n < 0 ? -static_cast<unsigned long>(n) : n;
+        mpfr_prec_t prec = mpfc_get_prec(r) + 32;
+        mpfc_ptr base;
+        mpfc_init2(base, prec);
+        mpfr_set(base->re, z->re, MPFR_RNDN);
+        mpfr_set(base->im, z->im, MPFR_RNDN);
+        mpfc_ptr acc;
+        mpfc_init2(acc, prec);
+        mpfr_set_ui(acc->re, 1, MPFR_RNDN);
+        mpfr_set_zero(acc->im, 1);
+        while (e != 0) {
+                if ((e & 1) != 0)
+                        mpfc_mul(acc, acc, base);
+                e >>= 1;
+                if (e != 0)
+                        mpfc_mul(base, base, base);
+        }
+        if (n < 0) {
+                mpfr_set_ui(base->re, 1, MPFR_RNDN);
+                mpfr_set_zero(base->im, 1);
+                mpfc_div(r, base, acc);
+        }
+        else {
+                mpfr_set(r->re, acc->re, MPFR_RNDN);
+                mpfr_set(r->im, acc->im, MPFR_RNDN);
+        }
+        mpfc_clear(base);
+        mpfc_clear(acc);
+}
+
+typedef void (*mpqc_func2)(mpqc_ptr, mpqc_srcptr, mpqc_srcptr);
+typedef void (*mpfc_func2)(mpfc_ptr, mpfc_srcptr, mpfc_srcptr);
+
+static numeric mpqc_apply(mpqc_func2 f, mpqc_srcptr a, mpqc_srcptr b)
+{
+        mpqc_ptr gaussrat;
+        mpqc_init(gaussrat);
+        f(gaussrat, a, b);
+        return gaussrat;
+}
+
+static numeric mpfc_apply(mpfc_func2 f, mpfc_srcptr a, mpfc_srcptr b)
+{
+        mpfc_ptr bigcomplex;
+        mpfc_init2(bigcomplex, std::min(mpfc_get_prec(a), mpfc_get_prec(b)));
+        f(bigcomplex, a, b);
+        return bigcomplex;
+}
+
+/* Python hashes a complex number by combining the hashes of its parts,
+   which Sage's ComplexNumber follows. */
+static long _complex_pythonhash(long hre, long him)
+{
+    unsigned long h = static_cast<unsigned long>(hre)
+            + 1000003UL * static_cast<unsigned long>(him);
+    long combined = static_cast<long>(h);
+    if (combined == -1)
+        return -2;
+    return combined;
+}
+
+static long _mpqc_pythonhash(mpqc_srcptr z)
+{
+    return _complex_pythonhash(_mpq_pythonhash(z->re),
+                               _mpq_pythonhash(z->im));
+}
+
+static long _mpfc_pythonhash(mpfc_ptr z)
+{
+    return _complex_pythonhash(_mpfr_pythonhash(z->re),
+                               _mpfr_pythonhash(z->im));
+}
+
+// Convert to an element of Sage's ComplexField of the same precision.
+// Returns a NEW REFERENCE.
+static PyObject* mpfc_to_pyobject(mpfc_srcptr z)
+{
+        PyObject* field = sage_field_get("ComplexField", mpfc_get_prec(z));
+        PyObject* re = mpfr_to_pyobject(z->re);
+        PyObject* im = mpfr_to_pyobject(z->im);
+        PyObject* ret = PyObject_CallFunctionObjArgs(field, re, im, NULL);
+        Py_DECREF(re);
+        Py_DECREF(im);
+        if (ret == nullptr)
+                py_error("Error converting MPFC float to ComplexNumber");
+        return ret;
+}
+
+// Convert to re+im*I with Sage's I.  Returns a NEW REFERENCE.
+static PyObject* mpqc_to_pyobject(mpqc_srcptr z)
+{
+        if (pyobject_I == nullptr)
+                throw std::runtime_error("mpqc_to_pyobject: I not initialized");
+        mpq_t bigrat;
+        mpq_init(bigrat);
+        mpq_set(bigrat, z->re);
+        PyObject* re = py_funcs.py_rational_from_mpq(bigrat);
+        mpq_set(bigrat, z->im);
+        PyObject* im = py_funcs.py_rational_from_mpq(bigrat);
+        mpq_clear(bigrat);
+        PyObject* t = PyNumber_Multiply(im, pyobject_I);
+        if (t == nullptr)
+                py_error("Error converting MPQC to Python");
+        PyObject* ret = PyNumber_Add(re, t);
+        if (ret == nullptr)
+                py_error("Error converting MPQC to Python");
+        Py_DECREF(re);
+        Py_DECREF(im);
+        Py_DECREF(t);
+        return ret;
+}
+
+
+//////////
+// Balls
+//////////
+
+static void ball_set(ball_ptr b, ball_srcptr x)
+{
+        acb_set(&b->z, &x->z);
+        b->prec = x->prec;
+}
+
+static void arb_set_mpq(arb_ptr r, mpq_srcptr q, slong prec)
+{
+        fmpq_t f;
+        fmpq_init(f);
+        fmpq_set_mpq(f, q);
+        arb_set_fmpq(r, f, prec);
+        fmpq_clear(f);
+}
+
+// An MPFR float is taken as the exact midpoint of the ball.
+static void arb_set_mpfr(arb_ptr r, mpfr_srcptr f)
+{
+        arf_set_mpfr(arb_midref(r), f);
+        mag_zero(arb_radref(r));
+}
+
+// Enclose any native number in a ball of the precision of b.
+static void ball_set_numeric(ball_ptr b, const numeric& x)
+{
+        arb_ptr re = acb_realref(&b->z);
+        arb_ptr im = acb_imagref(&b->z);
+        switch (x.t) {
+        case LONG:
+                acb_set_si(&b->z, x.v._long);
+                return;
+        case MPZ: {
+                fmpz_t f;
+                fmpz_init(f);
+                fmpz_set_mpz(f, x.v._bigint);
+                arb_set_round_fmpz(re, f, b->prec);
+                arb_zero(im);
+                fmpz_clear(f);
+                return;
+        }
+        case MPQ:
+                arb_set_mpq(re, x.v._bigrat, b->prec);
+                arb_zero(im);
+                return;
+        case MPFR:
+                arb_set_mpfr(re, x.v._bigfloat);
+                arb_zero(im);
+                return;
+        case MPFC:
+                arb_set_mpfr(re, x.v._bigcomplex->re);
+                arb_set_mpfr(im, x.v._bigcomplex->im);
+                return;
+        case MPQC:
+                arb_set_mpq(re, x.v._gaussrat->re, b->prec);
+                arb_set_mpq(im, x.v._gaussrat->im, b->prec);
+                return;
+        case ACB:
+                acb_set_round(&b->z, &x.v._ball->z, b->prec);
+                return;
+        default:
+                stub("ball_set_numeric: type not handled");
+        }
+}
+
+typedef void (*acb_func1)(acb_ptr, acb_srcptr, slong);
+typedef void (*acb_func2)(acb_ptr, acb_srcptr, acb_srcptr, slong);
+
+static numeric ball_apply(acb_func1 f, ball_srcptr a)
+{
+        ball_ptr ball;
+        ball_init(ball, a->prec);
+        f(&ball->z, &a->z, ball->prec);
+        return ball;
+}
+
+static numeric ball_apply(acb_func2 f, ball_srcptr a, ball_srcptr b)
+{
+        ball_ptr ball;
+        ball_init(ball, std::min(a->prec, b->prec));
+        f(&ball->z, &a->z, &b->z, ball->prec);
+        return ball;
+}
+
+static numeric ball_from_arb(arb_srcptr x, slong prec)
+{
+        ball_ptr ball;
+        ball_init(ball, prec);
+        acb_set_arb(&ball->z, x);
+        return ball;
+}
+
+// Sage hashes a ball like its midpoint.
+static long _ball_pythonhash(ball_srcptr b)
+{
+    mpfr_t f;
+    mpfr_init2(f, 53);
+    mpfr_set_d(f, arf_get_d(arb_midref(acb_realref(&b->z)), ARF_RND_NEAR),
+               MPFR_RNDN);
+    long hre = _mpfr_pythonhash(f);
+    mpfr_set_d(f, arf_get_d(arb_midref(acb_imagref(&b->z)), ARF_RND_NEAR),
+               MPFR_RNDN);
+    long him = _mpfr_pythonhash(f);
+    mpfr_clear(f);
+    return _complex_pythonhash(hre, him);
+}
+
+// Convert to an element of Sage's RealBallField, or ComplexBallField if
+// the imaginary part is not zero, of the same precision.
+// Returns a NEW REFERENCE.
+static PyObject* ball_to_pyobject(ball_srcptr b)
+{
+        PyObject* rbf = sage_field_get("RealBallField", b->prec);
+        PyObject* parts[2];
+        arb_srcptr x[2] = { acb_realref(&b->z), acb_imagref(&b->z) };
+        int nparts = (acb_is_real(&b->z) != 0) ? 1 : 2;
+        mpfr_t f;
+        arf_t rad;
+        arf_init(rad);
+        for (int i = 0; i < nparts; ++i) {
+                arf_srcptr mid = arb_midref(x[i]);
+                mpfr_init2(f, std::max<slong>(arf_bits(mid), MPFR_PREC_MIN));
+                arf_get_mpfr(f, mid, MPFR_RNDN);
+                PyObject* pymid = mpfr_to_pyobject(f);
+                mpfr_clear(f);
+                arf_set_mag(rad, arb_radref(x[i]));
+                mpfr_init2(f, std::max<slong>(arf_bits(rad), MPFR_PREC_MIN));
+                arf_get_mpfr(f, rad, MPFR_RNDU);
+                PyObject* pyrad = mpfr_to_pyobject(f);
+                mpfr_clear(f);
+                parts[i] = PyObject_CallFunctionObjArgs(rbf, pymid, pyrad,
+                                                        NULL);
+                Py_DECREF(pymid);
+                Py_DECREF(pyrad);
+                if (parts[i] == nullptr)
+                        py_error("Error converting ball to RealBall");
+        }
+        arf_clear(rad);
+        if (nparts == 1)
+                return parts[0];
+        PyObject* cbf = sage_field_get("ComplexBallField", b->prec);
+        PyObject* ret = PyObject_CallFunctionObjArgs(cbf, parts[0], parts[1],
+                                                     NULL);
+        Py_DECREF(parts[0]);
+        Py_DECREF(parts[1]);
+        if (ret == nullptr)
+                py_error("Error converting ball to ComplexBall");
+        return ret;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -778,6 +1645,22 @@ numeric::numeric(const numeric& other) : basic(&numeric::tinfo_static) {
                 mpq_init(v._bigrat);
                 mpq_set(v._bigrat, other.v._bigrat);
                 return;
+        case MPFR:
+                mpfr_init2(v._bigfloat, mpfr_get_prec(other.v._bigfloat));
+                mpfr_set(v._bigfloat, other.v._bigfloat, MPFR_RNDN);
+                return;
+        case MPFC:
+                mpfc_init2(v._bigcomplex, mpfc_get_prec(other.v._bigcomplex));
+                mpfc_set_numeric(v._bigcomplex, other);
+                return;
+        case MPQC:
+                mpqc_init(v._gaussrat);
+                mpqc_set(v._gaussrat, other.v._gaussrat);
+                return;
+        case ACB:
+                ball_init(v._ball, other.v._ball->prec);
+                ball_set(v._ball, other.v._ball);
+                return;
         }
 }
 
@@ -792,7 +1675,7 @@ bool is_Sage_Integer(PyObject* o)
 
 void set_from(Type& t, Value& v, long& hash, mpz_t bigint)
 {
-        if (mpz_fits_sint_p(bigint)) {
+        if (mpz_fits_slong_p(bigint)) {
                 t = LONG;
                 v._long = mpz_get_si(bigint);
                 hash = (v._long==-1) ? -2 : v._long;
@@ -800,7 +1683,7 @@ void set_from(Type& t, Value& v, long& hash, mpz_t bigint)
         else {
                 t = MPZ;
                 mpz_init_set(v._bigint, bigint);
-                hash = _mpz_pythonhash(v._bigint);
+                hash = hash_pending;
         }
 }
 
@@ -809,7 +1692,23 @@ void set_from(Type& t, Value& v, long& hash, mpq_t bigrat)
         t = MPQ;
         mpq_init(v._bigrat);
         mpq_set(v._bigrat, bigrat);
-        hash = _mpq_pythonhash(v._bigrat);
+        hash = hash_pending;
+}
+
+// A Gaussian rational with zero imaginary part becomes a real number.
+void set_from(Type& t, Value& v, long& hash, mpqc_ptr gaussrat)
+{
+        if (mpq_sgn(gaussrat->im) == 0) {
+                if (mpz_cmp_ui(mpq_denref(gaussrat->re), 1) == 0)
+                        set_from(t, v, hash, mpq_numref(gaussrat->re));
+                else
+                        set_from(t, v, hash, gaussrat->re);
+                return;
+        }
+        t = MPQC;
+        mpqc_init(v._gaussrat);
+        mpqc_set(v._gaussrat, gaussrat);
+        hash = hash_pending;
 }
 
 numeric::numeric(PyObject* o, bool force_py) : basic(&numeric::tinfo_static) {
@@ -829,7 +1728,7 @@ numeric::numeric(PyObject* o, bool force_py) : basic(&numeric::tinfo_static) {
                     t = MPZ;
                     mpz_init(v._bigint);
                     _mpz_set_pylong(v._bigint, reinterpret_cast<PyLongObject*>( o));
-                    hash = _mpz_pythonhash(v._bigint);
+                    hash = hash_pending;
                     setflag(status_flags::evaluated | status_flags::expanded);
                     Py_DECREF(o);
                     return;
@@ -851,6 +1750,26 @@ numeric::numeric(PyObject* o, bool force_py) : basic(&numeric::tinfo_static) {
                                                 | status_flags::expanded);
                                 return;
                         }
+                        if (is_Gaussian_rational(o)) {
+                                PyObject* re = py_funcs.py_real(o);
+                                PyObject* im = py_funcs.py_imag(o);
+                                if (re == nullptr or im == nullptr)
+                                        py_error("Error getting parts of Gaussian rational");
+                                mpqc_ptr gaussrat;
+                                mpqc_init(gaussrat);
+                                mpq_set(gaussrat->re,
+                                        py_funcs.py_mpq_from_rational(re));
+                                mpq_set(gaussrat->im,
+                                        py_funcs.py_mpq_from_rational(im));
+                                set_from(t, v, hash, gaussrat);
+                                mpqc_clear(gaussrat);
+                                Py_DECREF(re);
+                                Py_DECREF(im);
+                                Py_DECREF(o);
+                                setflag(status_flags::evaluated
+                                                | status_flags::expanded);
+                                return;
+                        }
                 }
         }
 
@@ -880,6 +1799,51 @@ numeric::numeric(mpq_t bigrat) : basic(&numeric::tinfo_static)
         setflag(status_flags::evaluated | status_flags::expanded);
 }
 
+/** Constructor from an MPFR float, which is cleared afterwards. */
+numeric::numeric(mpfr_t bigfloat) : basic(&numeric::tinfo_static)
+{
+        t = MPFR;
+        mpfr_init2(v._bigfloat, mpfr_get_prec(bigfloat));
+        mpfr_swap(v._bigfloat, bigfloat);
+        mpfr_clear(bigfloat);
+        hash = _mpfr_pythonhash(v._bigfloat);
+        setflag(status_flags::evaluated | status_flags::expanded);
+}
+
+/** Constructor from a complex MPFR float, which the numeric takes over. */
+numeric::numeric(mpfc_ptr bigcomplex) : basic(&numeric::tinfo_static)
+{
+        t = MPFC;
+        v._bigcomplex = bigcomplex;
+        hash = _mpfc_pythonhash(v._bigcomplex);
+        setflag(status_flags::evaluated | status_flags::expanded);
+}
+
+/** Constructor from a Gaussian rational, which the numeric takes over,
+ *  or clears if it is real. */
+numeric::numeric(mpqc_ptr gaussrat) : basic(&numeric::tinfo_static)
+{
+        if (mpq_sgn(gaussrat->im) != 0) {
+                t = MPQC;
+                v._gaussrat = gaussrat;
+                hash = hash_pending;
+        }
+        else {
+                set_from(t, v, hash, gaussrat);
+                mpqc_clear(gaussrat);
+        }
+        setflag(status_flags::evaluated | status_flags::expanded);
+}
+
+/** Constructor from a ball, which the numeric takes over. */
+numeric::numeric(ball_ptr ball) : basic(&numeric::tinfo_static)
+{
+        t = ACB;
+        v._ball = ball;
+        hash = _ball_pythonhash(v._ball);
+        setflag(status_flags::evaluated | status_flags::expanded);
+}
+
 /** Constructor for rational numerics a/b.
  *
  *  @exception overflow_error (division by zero) */
@@ -897,7 +1861,7 @@ numeric::numeric(long num, long den) : basic(&numeric::tinfo_static) {
                 mpq_init(v._bigrat);
                 mpq_set_si(v._bigrat, num, den);
                 mpq_canonicalize(v._bigrat);
-                hash = _mpq_pythonhash(v._bigrat);
+                hash = hash_pending;
         }
         setflag(status_flags::evaluated | status_flags::expanded);
 }
@@ -922,6 +1886,18 @@ numeric::~numeric() {
         case MPQ:
                 mpq_clear(v._bigrat);
                 return;
+        case MPFR:
+                mpfr_clear(v._bigfloat);
+                return;
+        case MPFC:
+                mpfc_clear(v._bigcomplex);
+                return;
+        case MPQC:
+                mpqc_clear(v._gaussrat);
+                return;
+        case ACB:
+                ball_clear(v._ball);
+                return;
         }
 }
 
@@ -949,13 +1925,62 @@ inherited(n, sym_lst) {
         case MPZ:
                 mpz_init(v._bigint);
                 mpz_set_str(v._bigint, str.c_str(), 10);
-                hash = _mpz_pythonhash(v._bigint);
+                hash = hash_pending;
                 return;
         case MPQ:
                 mpq_init(v._bigrat);
                 mpq_set_str(v._bigrat, str.c_str(), 10);
-                hash = _mpq_pythonhash(v._bigrat);
+                hash = hash_pending;
                 return;
+        case MPFR: {
+                unsigned int prec;
+                if (!n.find_unsigned(std::string("P"), prec))
+                        throw std::runtime_error("archive error: cannot read precision");
+                mpfr_init2(v._bigfloat, prec);
+                mpfr_set_str(v._bigfloat, str.c_str(), 0, MPFR_RNDN);
+                hash = _mpfr_pythonhash(v._bigfloat);
+                return;
+        }
+        case MPFC: {
+                unsigned int prec;
+                if (!n.find_unsigned(std::string("P"), prec))
+                        throw std::runtime_error("archive error: cannot read precision");
+                size_t sep = str.find(' ');
+                if (sep == std::string::npos)
+                        throw std::runtime_error("archive error: cannot read complex number");
+                mpfc_init2(v._bigcomplex, prec);
+                mpfr_set_str(v._bigcomplex->re, str.substr(0, sep).c_str(),
+                                0, MPFR_RNDN);
+                mpfr_set_str(v._bigcomplex->im, str.substr(sep+1).c_str(),
+                                0, MPFR_RNDN);
+                hash = _mpfc_pythonhash(v._bigcomplex);
+                return;
+        }
+        case MPQC: {
+                size_t sep = str.find(' ');
+                if (sep == std::string::npos)
+                        throw std::runtime_error("archive error: cannot read complex number");
+                mpqc_init(v._gaussrat);
+                mpq_set_str(v._gaussrat->re, str.substr(0, sep).c_str(), 10);
+                mpq_set_str(v._gaussrat->im, str.substr(sep+1).c_str(), 10);
+                hash = hash_pending;
+                return;
+        }
+        case ACB: {
+                // parts in arb's own exact format
+                unsigned int prec;
+                if (!n.find_unsigned(std::string("P"), prec))
+                        throw std::runtime_error("archive error: cannot read precision");
+                std::string imstr;
+                if (!n.find_string("I", imstr))
+                        throw std::runtime_error("archive error: cannot read ball");
+                ball_init(v._ball, prec);
+                if (arb_load_str(acb_realref(&v._ball->z), str.c_str()) != 0
+                    or arb_load_str(acb_imagref(&v._ball->z), imstr.c_str()) != 0)
+                        throw std::runtime_error("archive error: cannot read ball");
+                hash = _ball_pythonhash(v._ball);
+                return;
+        }
         case PYOBJECT:
                 // read pickled python object to a string
                 if (!n.find_string("S", str))
@@ -1005,6 +2030,47 @@ void numeric::archive(archive_node &n) const {
                 tstr = new std::string(&cp[0]);
                 break;
         }
+        case MPFR: {
+                // exact hexadecimal representation
+                char *str;
+                mpfr_asprintf(&str, "%Ra", v._bigfloat);
+                tstr = new std::string(str);
+                mpfr_free_str(str);
+                n.add_unsigned("P", mpfr_get_prec(v._bigfloat));
+                break;
+        }
+        case MPFC: {
+                char *str;
+                mpfr_asprintf(&str, "%Ra %Ra", v._bigcomplex->re,
+                                v._bigcomplex->im);
+                tstr = new std::string(str);
+                mpfr_free_str(str);
+                n.add_unsigned("P", mpfc_get_prec(v._bigcomplex));
+                break;
+        }
+        case MPQC: {
+                size_t size = mpz_sizeinbase(mpq_numref(v._gaussrat->re), 10)
+                + mpz_sizeinbase(mpq_denref(v._gaussrat->re), 10)
+                + mpz_sizeinbase(mpq_numref(v._gaussrat->im), 10)
+                + mpz_sizeinbase(mpq_denref(v._gaussrat->im), 10) + 10;
+                std::vector<char> cp(size);
+                mpq_get_str(&cp[0], 10, v._gaussrat->re);
+                tstr = new std::string(&cp[0]);
+                tstr->push_back(' ');
+                mpq_get_str(&cp[0], 10, v._gaussrat->im);
+                tstr->append(&cp[0]);
+                break;
+        }
+        case ACB: {
+                char *str = arb_dump_str(acb_realref(&v._ball->z));
+                tstr = new std::string(str);
+                flint_free(str);
+                str = arb_dump_str(acb_imagref(&v._ball->z));
+                n.add_string("I", str);
+                flint_free(str);
+                n.add_unsigned("P", v._ball->prec);
+                break;
+        }
         case PYOBJECT:
                 tstr = py_funcs.py_dumps(v._pyobject);
                 if (PyErr_Occurred() != nullptr) {
@@ -1069,6 +2135,18 @@ static std::string dbgstring(const numeric& num)
         case MPQ:
                 ts = "MPQ";
                 break;
+        case MPFR:
+                ts = "MPFR";
+                break;
+        case MPFC:
+                ts = "MPFC";
+                break;
+        case MPQC:
+                ts = "MPQC";
+                break;
+        case ACB:
+                ts = "ACB";
+                break;
         case PYOBJECT:
                 {
                 ts = "PYOBJECT: ";
@@ -1213,7 +2291,28 @@ numeric numeric::conj() const {
         switch (t) {
         case LONG:
         case MPZ:
-        case MPQ: return *this;
+        case MPQ:
+        case MPFR: return *this;
+        case MPFC: {
+                mpfc_ptr bigcomplex;
+                mpfc_init2(bigcomplex, mpfc_get_prec(v._bigcomplex));
+                mpfr_set(bigcomplex->re, v._bigcomplex->re, MPFR_RNDN);
+                mpfr_neg(bigcomplex->im, v._bigcomplex->im, MPFR_RNDN);
+                return bigcomplex;
+        }
+        case MPQC: {
+                mpqc_ptr gaussrat;
+                mpqc_init(gaussrat);
+                mpq_set(gaussrat->re, v._gaussrat->re);
+                mpq_neg(gaussrat->im, v._gaussrat->im);
+                return gaussrat;
+        }
+        case ACB: {
+                ball_ptr ball;
+                ball_init(ball, v._ball->prec);
+                acb_conj(&ball->z, &v._ball->z);
+                return ball;
+        }
         case PYOBJECT: {
                 PyObject *obj = PyObject_GetAttrString(v._pyobject,
                 "conjugate");
@@ -1262,9 +2361,16 @@ bool numeric::is_equal_same_type(const basic &other) const {
 long numeric::calchash() const {
         switch (t) {
         case LONG:
-                return (v._long == -1) ? -2 : v._long;
+                return _long_pythonhash(v._long);
         case MPZ:
+                return CACHED_HASH(hash, _mpz_pythonhash(v._bigint));
         case MPQ:
+                return CACHED_HASH(hash, _mpq_pythonhash(v._bigrat));
+        case MPQC:
+                return CACHED_HASH(hash, _mpqc_pythonhash(v._gaussrat));
+        case MPFR:
+        case MPFC:
+        case ACB:
         case PYOBJECT:
                 if (is_hashable)
                         return hash;
@@ -1287,6 +2393,54 @@ long numeric::calchash() const {
 
 // public
 
+// The overflow checks on LONG operands are exact, so a result that
+// needs an mpz does not fit into a long.
+#if defined __has_builtin
+#  if __has_builtin (__builtin_saddl_overflow)
+#    define saddl_overflow __builtin_saddl_overflow
+#  endif
+#  if __has_builtin (__builtin_ssubl_overflow)
+#    define ssubl_overflow __builtin_ssubl_overflow
+#  endif
+#  if __has_builtin (__builtin_smull_overflow)
+#    define smull_overflow __builtin_smull_overflow
+#  endif
+#endif
+
+#if !defined saddl_overflow
+static int saddl_overflow(long a, long b, long *result) {
+        if ((b > 0 and a > std::numeric_limits<long>::max() - b)
+            or (b < 0 and a < std::numeric_limits<long>::min() - b))
+                return 1;
+        *result = a + b;
+        return 0;
+}
+#endif
+
+#if !defined ssubl_overflow
+static int ssubl_overflow(long a, long b, long *result) {
+        if ((b < 0 and a > std::numeric_limits<long>::max() + b)
+            or (b > 0 and a < std::numeric_limits<long>::min() + b))
+                return 1;
+        *result = a - b;
+        return 0;
+}
+#endif
+
+#if !defined smull_overflow
+static int smull_overflow(long a, long b, long *result) {
+        if (a != 0 and b != 0) {
+                if (a > 0 ? (b > 0 ? a > std::numeric_limits<long>::max() / b
+                                   : b < std::numeric_limits<long>::min() / a)
+                          : (b > 0 ? a < std::numeric_limits<long>::min() / b
+                                   : b < std::numeric_limits<long>::max() / a))
+                        return 1;
+        }
+        *result = a * b;
+        return 0;
+}
+#endif
+
 /** Numerical addition method.  Adds argument to *this and returns result as
  *  a numeric object. */
 const numeric numeric::add(const numeric &other) const {
@@ -1317,17 +2471,15 @@ const numeric numeric::add(const numeric &other) const {
         }
         switch (t) {
         case LONG: {
-                if ((v._long > 0
-                    and v._long < std::numeric_limits<long>::max() / 2
-                    and other.v._long < std::numeric_limits<long>::max() / 2)
-                or (v._long < 0
-                   and v._long > std::numeric_limits<long>::min() / 2
-                   and other.v._long > std::numeric_limits<long>::min() / 2))
-                        return v._long + other.v._long;
+                long result;
+                if (not saddl_overflow(v._long, other.v._long, & result))
+                        return result;
+                // the addition overflowed, so use mpz
                 mpz_t bigint;
                 mpz_init_set_si(bigint, v._long);
                 if (other.v._long < 0)
-                        mpz_sub_ui(bigint, bigint, -other.v._long);
+                        mpz_sub_ui(bigint, bigint,
+                                   -static_cast<unsigned long>(other.v._long));
                 else
                         mpz_add_ui(bigint, bigint, other.v._long);
                 return bigint;
@@ -1342,6 +2494,14 @@ const numeric numeric::add(const numeric &other) const {
                 mpq_init(bigrat);
                 mpq_add(bigrat, v._bigrat, other.v._bigrat);
                 return bigrat;
+        case MPFR:
+                return mpfr_apply(mpfr_add, v._bigfloat, other.v._bigfloat);
+        case MPFC:
+                return mpfc_apply(mpfc_add, v._bigcomplex, other.v._bigcomplex);
+        case MPQC:
+                return mpqc_apply(mpqc_add, v._gaussrat, other.v._gaussrat);
+        case ACB:
+                return ball_apply(acb_add, v._ball, other.v._ball);
         case PYOBJECT:
                 return PyNumber_Add(v._pyobject, other.v._pyobject);
         default:
@@ -1382,17 +2542,15 @@ const numeric numeric::sub(const numeric &other) const {
         }
         switch (t) {
         case LONG: {
-                if ((v._long > 0
-                    and v._long < std::numeric_limits<long>::max() / 2
-                    and -other.v._long < std::numeric_limits<long>::max() / 2)
-                or (v._long < 0
-                   and v._long > std::numeric_limits<long>::min() / 2
-                   and -other.v._long > std::numeric_limits<long>::min() / 2))
-                        return v._long - other.v._long;
+                long result;
+                if (not ssubl_overflow(v._long, other.v._long, & result))
+                        return result;
+                // the subtraction overflowed, so use mpz
                 mpz_t bigint;
                 mpz_init_set_si(bigint, v._long);
                 if (other.v._long < 0)
-                        mpz_add_ui(bigint, bigint, -other.v._long);
+                        mpz_add_ui(bigint, bigint,
+                                   -static_cast<unsigned long>(other.v._long));
                 else
                         mpz_sub_ui(bigint, bigint, other.v._long);
                 return bigint;
@@ -1405,40 +2563,32 @@ const numeric numeric::sub(const numeric &other) const {
         case MPQ:
                 mpq_t bigrat;
                 mpq_init(bigrat);
-                mpq_sub(bigrat, v._bigrat, other.v._bigrat);
-                return bigrat;
-        case PYOBJECT:
-                return PyNumber_Subtract(v._pyobject, other.v._pyobject);
-        default:
-                stub("invalid type: operator-() type not handled");
-        }
-}
-
-#if defined __has_builtin
-#  if __has_builtin (__builtin_smull_overflow)
-#    define smull_overflow __builtin_smull_overflow
-#  endif
-#endif
-
-#if !defined smull_overflow
-static int smull_overflow(long a, long b, long *result) {
-        static long lsqrt = std::lround(std::sqrt(std::numeric_limits<long>::max()));
-        if (-lsqrt < a and a < lsqrt and -lsqrt < b and b < lsqrt) {
-                // Will not overflow.
-                *result = a * b;
-                return 0;
+                mpq_sub(bigrat, v._bigrat, other.v._bigrat);
+                return bigrat;
+        case MPFR:
+                return mpfr_apply(mpfr_sub, v._bigfloat, other.v._bigfloat);
+        case MPFC:
+                return mpfc_apply(mpfc_sub, v._bigcomplex, other.v._bigcomplex);
+        case MPQC:
+                return mpqc_apply(mpqc_sub, v._gaussrat, other.v._gaussrat);
+        case ACB:
+                return ball_apply(acb_sub, v._ball, other.v._ball);
+        case PYOBJECT:
+                return PyNumber_Subtract(v._pyobject, other.v._pyobject);
+        default:
+                stub("invalid type: operator-() type not handled");
         }
-        // May overflow.
-        return 1;
 }
-#endif
 
 /** Numerical multiplication method.  Multiplies *this and argument and returns
  *  result as a numeric object. */
 const numeric numeric::mul(const numeric &other) const {
         verbose("operator*");
-        if ((is_zero() and t != PYOBJECT)
-            or (other.is_zero() and other.t != PYOBJECT))
+        // an inexact zero stays inexact
+        if ((is_zero() and t != PYOBJECT and t != MPFR and t != MPFC
+             and t != ACB)
+            or (other.is_zero() and other.t != PYOBJECT
+                and other.t != MPFR and other.t != MPFC and other.t != ACB))
                 return *_num0_p;
         if (other.is_one())
                 return *this;
@@ -1470,6 +2620,14 @@ const numeric numeric::mul(const numeric &other) const {
                 mpq_init(bigrat);
                 mpq_mul(bigrat, v._bigrat, other.v._bigrat);
                 return bigrat;
+        case MPFR:
+                return mpfr_apply(mpfr_mul, v._bigfloat, other.v._bigfloat);
+        case MPFC:
+                return mpfc_apply(mpfc_mul, v._bigcomplex, other.v._bigcomplex);
+        case MPQC:
+                return mpqc_apply(mpqc_mul, v._gaussrat, other.v._gaussrat);
+        case ACB:
+                return ball_apply(acb_mul, v._ball, other.v._ball);
         case PYOBJECT:
                 return PyNumber_Multiply(v._pyobject, other.v._pyobject);
         default:
@@ -1485,7 +2643,7 @@ const numeric numeric::div(const numeric &other) const {
         verbose("operator/");
         if (other.is_zero())
                 throw std::overflow_error("numeric::div(): division by zero");
-        if (is_zero())
+        if (is_zero() and t != MPFR and t != MPFC and t != ACB)
                 return *_num0_p;
         if (other.is_one())
                 return *this;
@@ -1536,6 +2694,14 @@ const numeric numeric::div(const numeric &other) const {
                 mpq_div(bigrat, v._bigrat, other.v._bigrat);
                 return bigrat;
         }
+        case MPFR:
+                return mpfr_apply(mpfr_div, v._bigfloat, other.v._bigfloat);
+        case MPFC:
+                return mpfc_apply(mpfc_div, v._bigcomplex, other.v._bigcomplex);
+        case MPQC:
+                return mpqc_apply(mpqc_div, v._gaussrat, other.v._gaussrat);
+        case ACB:
+                return ball_apply(acb_div, v._ball, other.v._ball);
         case PYOBJECT:
 #if PY_MAJOR_VERSION < 3
                 if (PyObject_Compare(other.v._pyobject, ONE) == 0
@@ -1809,6 +2975,30 @@ const numeric numeric::power(signed long exp_si) const
                 mpz_clear(bigint);
                 mpq_clear(obigrat);
                 return numeric(bigrat);
+        case MPFR: {
+                mpfr_t bigfloat;
+                mpfr_init2(bigfloat, mpfr_get_prec(v._bigfloat));
+                mpfr_pow_si(bigfloat, v._bigfloat, exp_si, MPFR_RNDN);
+                return numeric(bigfloat);
+        }
+        case MPFC: {
+                mpfc_ptr bigcomplex;
+                mpfc_init2(bigcomplex, mpfc_get_prec(v._bigcomplex));
+                mpfc_pow_si(bigcomplex, v._bigcomplex, exp_si);
+                return numeric(bigcomplex);
+        }
+        case MPQC: {
+                mpqc_ptr gaussrat;
+                mpqc_init(gaussrat);
+                mpqc_pow_si(gaussrat, v._gaussrat, exp_si);
+                return numeric(gaussrat);
+        }
+        case ACB: {
+                ball_ptr ball;
+                ball_init(ball, v._ball->prec);
+                acb_pow_si(&ball->z, &v._ball->z, exp_si, ball->prec);
+                return numeric(ball);
+        }
         case PYOBJECT:
                 o = Integer(exp_si);
                 r = PyNumber_Power(v._pyobject, o, Py_None);
@@ -1866,6 +3056,59 @@ const ex numeric::power(const numeric &exponent) const {
                 }
         }
 
+        // MPFR floats in base or exponent; a negative base with a
+        // non-integer exponent has a complex result, which Sage computes
+        if ((t == MPFR and (expo.t == LONG or expo.t == MPZ or expo.t == MPQ
+                            or expo.t == MPFR))
+            or (expo.t == MPFR and (t == LONG or t == MPZ or t == MPQ))) {
+                if (t == MPFR and expo.is_integer())
+                        return pow_intexp(expo);
+                numeric a, b;
+                coerce(a, b, *this, expo);
+                if (not a.is_negative()) {
+                        mpfr_t bigfloat;
+                        mpfr_init2(bigfloat, mpfr_common_prec(a.v._bigfloat,
+                                                b.v._bigfloat));
+                        mpfr_pow(bigfloat, a.v._bigfloat, b.v._bigfloat,
+                                        MPFR_RNDN);
+                        return numeric(bigfloat);
+                }
+                PyObject *base = a.to_pyobject();
+                PyObject *obj = b.to_pyobject();
+                const numeric& ret = numeric(PyNumber_Power(base,
+                                        obj, Py_None));
+                Py_DECREF(base);
+                Py_DECREF(obj);
+                return ret;
+        }
+
+        // balls in base or exponent
+        if (t != PYOBJECT and expo.t != PYOBJECT
+            and (t == ACB or expo.t == ACB)) {
+                if (expo.is_integer())
+                        return pow_intexp(expo);
+                numeric a, b;
+                coerce(a, b, *this, expo);
+                return ball_apply(acb_pow, a.v._ball, b.v._ball);
+        }
+
+        // complex floats, or a float and a Gaussian rational, in base and
+        // exponent; only integer powers are computed natively
+        if (t != PYOBJECT and expo.t != PYOBJECT
+            and (t == MPFC or expo.t == MPFC
+                 or ((t == MPFR or expo.t == MPFR)
+                     and (t == MPQC or expo.t == MPQC)))) {
+                if (expo.is_integer())
+                        return pow_intexp(expo);
+                PyObject *base = to_pyobject();
+                PyObject *obj = expo.to_pyobject();
+                const numeric& ret = numeric(PyNumber_Power(base,
+                                        obj, Py_None));
+                Py_DECREF(base);
+                Py_DECREF(obj);
+                return ret;
+        }
+
         // inexact PyObjects in base or exponent
         if (t == PYOBJECT and not is_exact()) {
                 if (expo.t == PYOBJECT)
@@ -1990,6 +3233,16 @@ const ex numeric::power(const numeric &exponent) const {
 }
 
 
+/** Put the result of one of the *_dyn methods on the heap, unless it is a
+ *  small integer, for which the flyweight is returned. */
+static const numeric &dyn_result(const numeric &n)
+{
+        if (n.is_long() and is_small_int(n.v._long))
+                return *small_int_flyweight(n.v._long);
+        return static_cast<const numeric &> ((new numeric(n))->
+                setflag(status_flags::dynallocated));
+}
+
 /** Numerical addition method.  Adds argument to *this and returns result as
  *  a numeric object on the heap.  Use internally only for direct wrapping into
  *  an ex object, where the result would end up on the heap anyways. */
@@ -2001,8 +3254,7 @@ const numeric &numeric::add_dyn(const numeric &other) const {
         if (&other == _num0_p)
                 return *this;
 
-        return static_cast<const numeric &> ((new numeric(*this + other))->
-                setflag(status_flags::dynallocated));
+        return dyn_result(*this + other);
 }
 
 /** Numerical subtraction method.  Subtracts argument from *this and returns
@@ -2015,8 +3267,7 @@ const numeric &numeric::sub_dyn(const numeric &other) const {
         if (&other == _num0_p || (other.is_zero()))
                 return *this;
 
-        return static_cast<const numeric &> ((new numeric(*this - other))->
-                setflag(status_flags::dynallocated));
+        return dyn_result(*this - other);
 }
 
 /** Numerical multiplication method.  Multiplies *this and argument and returns
@@ -2031,8 +3282,7 @@ const numeric &numeric::mul_dyn(const numeric &other) const {
         if (&other == _num1_p)
                 return *this;
 
-        return static_cast<const numeric &> ((new numeric(*this * other))->
-                setflag(status_flags::dynallocated));
+        return dyn_result(*this * other);
 }
 
 /** Numerical division method.  Divides *this by argument and returns result as
@@ -2048,8 +3298,7 @@ const numeric &numeric::div_dyn(const numeric &other) const {
                 return *this;
         if (other.is_zero())
                 throw std::overflow_error("division by zero");
-        return static_cast<const numeric &> ((new numeric(*this / other))->
-                setflag(status_flags::dynallocated));
+        return dyn_result(*this / other);
 }
 
 /** Numerical exponentiation.  Raises *this to the power given as argument and
@@ -2102,6 +3351,28 @@ const numeric numeric::negative() const {
                 mpq_set(bigrat, v._bigrat);
                 mpq_neg(bigrat, bigrat);
                 return bigrat;
+        case MPFR:
+                return mpfr_apply(mpfr_neg, v._bigfloat);
+        case MPFC: {
+                mpfc_ptr bigcomplex;
+                mpfc_init2(bigcomplex, mpfc_get_prec(v._bigcomplex));
+                mpfr_neg(bigcomplex->re, v._bigcomplex->re, MPFR_RNDN);
+                mpfr_neg(bigcomplex->im, v._bigcomplex->im, MPFR_RNDN);
+                return bigcomplex;
+        }
+        case MPQC: {
+                mpqc_ptr gaussrat;
+                mpqc_init(gaussrat);
+                mpq_neg(gaussrat->re, v._gaussrat->re);
+                mpq_neg(gaussrat->im, v._gaussrat->im);
+                return gaussrat;
+        }
+        case ACB: {
+                ball_ptr ball;
+                ball_init(ball, v._ball->prec);
+                acb_neg(&ball->z, &v._ball->z);
+                return ball;
+        }
         case PYOBJECT:
                 return PyNumber_Negative(v._pyobject);
         default:
@@ -2111,89 +3382,108 @@ const numeric numeric::negative() const {
 
 // binary arithmetic assignment operators with numeric
 
-numeric & operator+=(numeric & lh, const numeric & rh)
+/** In-place addition.  Adds argument to *this, avoiding the temporary of
+ *  add() for exact numbers.  Integer results are stored as LONG where they
+ *  fit.  *this must not be shared. */
+numeric & numeric::add_to(const numeric & other)
 {
-        if (rh.is_zero())
-                return lh;
-        if (lh.is_zero()) {
-                lh = rh;
-                return lh;
+        if (other.is_zero())
+                return *this;
+        if (is_zero()) {
+                *this = other;
+                return *this;
         }
-        if (lh.t != rh.t) {
-                if (lh.t == MPZ and rh.t == MPQ) {
+        if (t != other.t) {
+                if (t == MPZ and other.t == MPQ) {
                         mpz_t bigint;
-                        mpz_init_set(bigint, lh.v._bigint);
-                        mpz_clear(lh.v._bigint);
-                        lh.t = MPQ;
-                        mpq_init(lh.v._bigrat);
-                        mpq_set_z(lh.v._bigrat, bigint);
-                        mpq_add(lh.v._bigrat, lh.v._bigrat, rh.v._bigrat);
-                        lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                        mpz_init_set(bigint, v._bigint);
+                        mpz_clear(v._bigint);
+                        t = MPQ;
+                        mpq_init(v._bigrat);
+                        mpq_set_z(v._bigrat, bigint);
+                        mpq_add(v._bigrat, v._bigrat, other.v._bigrat);
+                        hash = hash_pending;
                         mpz_clear(bigint);
-                        return lh;
+                        return *this;
                 }
-                if (lh.t == MPQ and rh.t == MPZ) {
+                if (t == MPQ and other.t == MPZ) {
                         mpq_t tmp;
                         mpq_init(tmp);
-                        mpq_set_z(tmp, rh.v._bigint);
-                        mpq_add(lh.v._bigrat, lh.v._bigrat, tmp);
-                        lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                        mpq_set_z(tmp, other.v._bigint);
+                        mpq_add(v._bigrat, v._bigrat, tmp);
+                        hash = hash_pending;
                         mpq_clear(tmp);
-                        return lh;
+                        return *this;
                 }
 
                 numeric a, b;
-                coerce(a, b, lh, rh);
-                lh = a + b;
-                return lh;
+                coerce(a, b, *this, other);
+                *this = a + b;
+                return *this;
         }
-        switch (lh.t) {
+        switch (t) {
         case LONG: {
-                if ((lh.v._long > 0
-                    and lh.v._long < std::numeric_limits<long>::max() / 2
-                    and rh.v._long < std::numeric_limits<long>::max() / 2)
-                or (lh.v._long < 0
-                   and lh.v._long > std::numeric_limits<long>::min() / 2
-                   and rh.v._long > std::numeric_limits<long>::min() / 2)) {
-                        lh.v._long += rh.v._long;
-                        lh.hash = (lh.v._long == -1) ? -2 : lh.v._long;
-                        return lh;
+                long result;
+                if (not saddl_overflow(v._long, other.v._long, & result)) {
+                        v._long = result;
+                        hash = _long_pythonhash(v._long);
+                        return *this;
                 }
-                lh.t = MPZ;
-                mpz_init_set_si(lh.v._bigint, lh.v._long);
-                if (rh.v._long < 0)
-                        mpz_sub_ui(lh.v._bigint,
-                        lh.v._bigint, -rh.v._long);
+                // the addition overflowed, so use mpz
+                long l = v._long;
+                t = MPZ;
+                mpz_init_set_si(v._bigint, l);
+                if (other.v._long < 0)
+                        mpz_sub_ui(v._bigint, v._bigint,
+                                   -static_cast<unsigned long>(other.v._long));
                 else
-                        mpz_add_ui(lh.v._bigint, lh.v._bigint,
-                        rh.v._long);
-                lh.hash = _mpz_pythonhash(lh.v._bigint);
-                return lh;
+                        mpz_add_ui(v._bigint, v._bigint, other.v._long);
+                hash = hash_pending;
+                return *this;
         }
         case MPZ:
-                mpz_add(lh.v._bigint, lh.v._bigint, rh.v._bigint);
-                lh.hash = _mpz_pythonhash(lh.v._bigint);
-                return lh;
+                mpz_add(v._bigint, v._bigint, other.v._bigint);
+                hash = hash_pending;
+                canonicalize();
+                return *this;
         case MPQ:
-                mpq_add(lh.v._bigrat, lh.v._bigrat, rh.v._bigrat);
-                lh.hash = _mpq_pythonhash(lh.v._bigrat);
-                return lh;
+                mpq_add(v._bigrat, v._bigrat, other.v._bigrat);
+                hash = hash_pending;
+                canonicalize();
+                return *this;
+        case MPFR:
+                *this = mpfr_apply(mpfr_add, v._bigfloat, other.v._bigfloat);
+                return *this;
+        case MPFC:
+                *this = mpfc_apply(mpfc_add, v._bigcomplex, other.v._bigcomplex);
+                return *this;
+        case MPQC:
+                *this = mpqc_apply(mpqc_add, v._gaussrat, other.v._gaussrat);
+                return *this;
+        case ACB:
+                *this = ball_apply(acb_add, v._ball, other.v._ball);
+                return *this;
         case PYOBJECT: {
-                PyObject *p = lh.v._pyobject;
-                lh.v._pyobject = PyNumber_Add(p, rh.v._pyobject);
-                if (lh.v._pyobject == nullptr) {
-                        lh.v._pyobject = p;
-                        py_error("numeric operator+=");
+                PyObject *p = v._pyobject;
+                v._pyobject = PyNumber_Add(p, other.v._pyobject);
+                if (v._pyobject == nullptr) {
+                        v._pyobject = p;
+                        py_error("numeric::add_to()");
                 }
-                lh.hash = PyObject_Hash(lh.v._pyobject);
+                hash = PyObject_Hash(v._pyobject);
                 Py_DECREF(p);
-                return lh;
+                return *this;
         }
         default:
-                stub("invalid type: operator+=() type not handled");
+                stub("invalid type: add_to() type not handled");
         }
 }
 
+numeric & operator+=(numeric & lh, const numeric & rh)
+{
+        return lh.add_to(rh);
+}
+
 numeric & operator-=(numeric & lh, const numeric & rh)
 {
         if (rh.is_zero())
@@ -2211,7 +3501,7 @@ numeric & operator-=(numeric & lh, const numeric & rh)
                         mpq_init(lh.v._bigrat);
                         mpq_set_z(lh.v._bigrat, bigint);
                         mpq_sub(lh.v._bigrat, lh.v._bigrat, rh.v._bigrat);
-                        lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                        lh.hash = hash_pending;
                         mpz_clear(bigint);
                         return lh;
                 }
@@ -2220,7 +3510,7 @@ numeric & operator-=(numeric & lh, const numeric & rh)
                         mpq_init(tmp);
                         mpq_set_z(tmp, rh.v._bigint);
                         mpq_sub(lh.v._bigrat, lh.v._bigrat, tmp);
-                        lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                        lh.hash = hash_pending;
                         mpq_clear(tmp);
                         return lh;
                 }
@@ -2232,34 +3522,45 @@ numeric & operator-=(numeric & lh, const numeric & rh)
         }
         switch (lh.t) {
         case LONG: {
-                if ((lh.v._long > 0
-                    and lh.v._long < std::numeric_limits<long>::max() / 2
-                    and -rh.v._long < std::numeric_limits<long>::max() / 2)
-                or (lh.v._long < 0
-                   and lh.v._long > std::numeric_limits<long>::min() / 2
-                   and -rh.v._long > std::numeric_limits<long>::min() / 2)) {
-                        lh.v._long -= rh.v._long;
-                        lh.hash = (lh.v._long == -1) ? -2 : lh.v._long;
+                long result;
+                if (not ssubl_overflow(lh.v._long, rh.v._long, & result)) {
+                        lh.v._long = result;
+                        lh.hash = _long_pythonhash(lh.v._long);
                         return lh;
                 }
+                // the subtraction overflowed, so use mpz
+                long l = lh.v._long;
                 lh.t = MPZ;
-                mpz_init_set_si(lh.v._bigint, lh.v._long);
+                mpz_init_set_si(lh.v._bigint, l);
                 if (rh.v._long < 0)
-                        mpz_add_ui(lh.v._bigint,
-                        lh.v._bigint, -rh.v._long);
+                        mpz_add_ui(lh.v._bigint, lh.v._bigint,
+                                   -static_cast<unsigned long>(rh.v._long));
                 else
-                        mpz_sub_ui(lh.v._bigint, lh.v._bigint,
-                        rh.v._long);
-                lh.hash = _mpz_pythonhash(lh.v._bigint);
+                        mpz_sub_ui(lh.v._bigint, lh.v._bigint, rh.v._long);
+                lh.hash = hash_pending;
                 return lh;
         }
         case MPZ:
                 mpz_sub(lh.v._bigint, lh.v._bigint, rh.v._bigint);
-                lh.hash = _mpz_pythonhash(lh.v._bigint);
+                lh.hash = hash_pending;
+                lh.canonicalize();
                 return lh;
         case MPQ:
                 mpq_sub(lh.v._bigrat, lh.v._bigrat, rh.v._bigrat);
-                lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                lh.hash = hash_pending;
+                lh.canonicalize();
+                return lh;
+        case MPFR:
+                lh = mpfr_apply(mpfr_sub, lh.v._bigfloat, rh.v._bigfloat);
+                return lh;
+        case MPFC:
+                lh = mpfc_apply(mpfc_sub, lh.v._bigcomplex, rh.v._bigcomplex);
+                return lh;
+        case MPQC:
+                lh = mpqc_apply(mpqc_sub, lh.v._gaussrat, rh.v._gaussrat);
+                return lh;
+        case ACB:
+                lh = ball_apply(acb_sub, lh.v._ball, rh.v._ball);
                 return lh;
         case PYOBJECT: {
                 PyObject *p = lh.v._pyobject;
@@ -2277,103 +3578,130 @@ numeric & operator-=(numeric & lh, const numeric & rh)
         }
 }
 
-numeric & operator*=(numeric & lh, const numeric & rh)
+/** In-place multiplication.  Multiplies *this by argument, avoiding the
+ *  temporary of mul() for exact numbers.  Integer results are stored as
+ *  LONG where they fit.  *this must not be shared. */
+numeric & numeric::mul_by(const numeric & other)
 {
-        if (rh.is_one())
-                return lh;
-        if (lh.is_one()) {
-                lh = rh;
-                return lh;
+        if (other.is_one())
+                return *this;
+        if (is_one()) {
+                *this = other;
+                return *this;
         }
-        if ((lh.is_zero() and lh.t != PYOBJECT)
-            or (rh.is_zero() and rh.t != PYOBJECT)) {
-                lh = *_num0_p;
-                return lh;
+        // an inexact zero stays inexact, as in mul()
+        if ((is_zero() and t != PYOBJECT and t != MPFR and t != MPFC
+             and t != ACB)
+            or (other.is_zero() and other.t != PYOBJECT
+                and other.t != MPFR and other.t != MPFC and other.t != ACB)) {
+                *this = *_num0_p;
+                return *this;
         }
-        if (lh.t != rh.t) {
-                if (lh.t == MPZ and rh.t == MPQ) {
+        if (t != other.t) {
+                if (t == MPZ and other.t == MPQ) {
                         mpq_t tmp;
                         mpq_init(tmp);
-                        mpq_set_z(tmp, lh.v._bigint);
-                        mpq_mul(tmp, tmp, rh.v._bigrat);
+                        mpq_set_z(tmp, v._bigint);
+                        mpq_mul(tmp, tmp, other.v._bigrat);
                         if (mpz_cmp_ui(mpq_denref(tmp),1) == 0) {
-                                mpz_set(lh.v._bigint, mpq_numref(tmp));
-                                lh.hash = _mpz_pythonhash(lh.v._bigint);
+                                mpz_set(v._bigint, mpq_numref(tmp));
+                                hash = hash_pending;
                                 mpq_clear(tmp);
-                                return lh;
+                                canonicalize();
+                                return *this;
                         }
-                        mpz_clear(lh.v._bigint);
-                        lh.t = MPQ;
-                        mpq_init(lh.v._bigrat);
-                        mpq_set(lh.v._bigrat, tmp);
-                        lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                        mpz_clear(v._bigint);
+                        t = MPQ;
+                        mpq_init(v._bigrat);
+                        mpq_set(v._bigrat, tmp);
+                        hash = hash_pending;
                         mpq_clear(tmp);
-                        return lh;
+                        return *this;
                 }
-                if (lh.t == MPQ and rh.t == MPZ) {
+                if (t == MPQ and other.t == MPZ) {
                         mpq_t tmp;
                         mpq_init(tmp);
-                        mpq_set_z(tmp, rh.v._bigint);
-                        mpq_mul(tmp, tmp, lh.v._bigrat);
+                        mpq_set_z(tmp, other.v._bigint);
+                        mpq_mul(tmp, tmp, v._bigrat);
                         if (mpz_cmp_ui(mpq_denref(tmp),1) != 0) {
-                                mpq_set(lh.v._bigrat, tmp);
-                                lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                                mpq_set(v._bigrat, tmp);
+                                hash = hash_pending;
                                 mpq_clear(tmp);
-                                return lh;
+                                return *this;
                         }
-                        mpq_clear(lh.v._bigrat);
-                        lh.t = MPZ;
-                        mpz_init(lh.v._bigint);
-                        mpz_set(lh.v._bigint, mpq_numref(tmp));
-                        lh.hash = _mpz_pythonhash(lh.v._bigint);
+                        mpq_clear(v._bigrat);
+                        t = MPZ;
+                        mpz_init(v._bigint);
+                        mpz_set(v._bigint, mpq_numref(tmp));
+                        hash = hash_pending;
                         mpq_clear(tmp);
-                        return lh;
+                        canonicalize();
+                        return *this;
                 }
 
                 numeric a, b;
-                coerce(a, b, lh, rh);
-                lh = a * b;
-                return lh;
+                coerce(a, b, *this, other);
+                *this = a * b;
+                return *this;
         }
-        switch (lh.t) {
+        switch (t) {
         case LONG: {
                 long result;
-                if (!smull_overflow(lh.v._long, rh.v._long, & result)) {
-                        lh.v._long = result;
-                        lh.hash = (lh.v._long==-1) ? -2 : lh.v._long;
-                        return lh;
+                if (not smull_overflow(v._long, other.v._long, & result)) {
+                        v._long = result;
+                        hash = _long_pythonhash(v._long);
+                        return *this;
                 }
                 // the multiplication overflowed, so use mpz
-                lh.t = MPZ;
-                mpz_init_set_si(lh.v._bigint, lh.v._long);
-                mpz_mul_si(lh.v._bigint, lh.v._bigint, rh.v._long);
-                lh.hash = _mpz_pythonhash(lh.v._bigint);
-                return lh;
+                long l = v._long;
+                t = MPZ;
+                mpz_init_set_si(v._bigint, l);
+                mpz_mul_si(v._bigint, v._bigint, other.v._long);
+                hash = hash_pending;
+                return *this;
         }
         case MPZ:
-                mpz_mul(lh.v._bigint, lh.v._bigint, rh.v._bigint);
-                lh.hash = _mpz_pythonhash(lh.v._bigint);
-                return lh;
+                mpz_mul(v._bigint, v._bigint, other.v._bigint);
+                hash = hash_pending;
+                return *this;
         case MPQ:
-                mpq_mul(lh.v._bigrat, lh.v._bigrat, rh.v._bigrat);
-                lh.hash = _mpq_pythonhash(lh.v._bigrat);
-                return lh;
+                mpq_mul(v._bigrat, v._bigrat, other.v._bigrat);
+                hash = hash_pending;
+                canonicalize();
+                return *this;
+        case MPFR:
+                *this = mpfr_apply(mpfr_mul, v._bigfloat, other.v._bigfloat);
+                return *this;
+        case MPFC:
+                *this = mpfc_apply(mpfc_mul, v._bigcomplex, other.v._bigcomplex);
+                return *this;
+        case MPQC:
+                *this = mpqc_apply(mpqc_mul, v._gaussrat, other.v._gaussrat);
+                return *this;
+        case ACB:
+                *this = ball_apply(acb_mul, v._ball, other.v._ball);
+                return *this;
         case PYOBJECT: {
-                PyObject *p = lh.v._pyobject;
-                lh.v._pyobject = PyNumber_Multiply(p, rh.v._pyobject);
-                if (lh.v._pyobject == nullptr) {
-                        lh.v._pyobject = p;
-                        py_error("numeric operator*=");
+                PyObject *p = v._pyobject;
+                v._pyobject = PyNumber_Multiply(p, other.v._pyobject);
+                if (v._pyobject == nullptr) {
+                        v._pyobject = p;
+                        py_error("numeric::mul_by()");
                 }
-                lh.hash = PyObject_Hash(lh.v._pyobject);
+                hash = PyObject_Hash(v._pyobject);
                 Py_DECREF(p);
-                return lh;
+                return *this;
         }
         default:
-                stub("invalid type: operator*=() type not handled");
+                stub("invalid type: mul_by() type not handled");
         }
 }
 
+numeric & operator*=(numeric & lh, const numeric & rh)
+{
+        return lh.mul_by(rh);
+}
+
 template <typename T> int sgn(T val) {
             return (T(0) < val) - (val < T(0));
 }
@@ -2391,7 +3719,7 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                         mpq_div(tmp, tmp, rh.v._bigrat);
                         if (mpz_cmp_ui(mpq_denref(tmp),1) == 0) {
                                 mpz_set(lh.v._bigint, mpq_numref(tmp));
-                                lh.hash = _mpz_pythonhash(lh.v._bigint);
+                                lh.hash = hash_pending;
                                 mpq_clear(tmp);
                                 return lh;
                         }
@@ -2399,7 +3727,7 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                         lh.t = MPQ;
                         mpq_init(lh.v._bigrat);
                         mpq_set(lh.v._bigrat, tmp);
-                        lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                        lh.hash = hash_pending;
                         mpq_clear(tmp);
                         return lh;
                 }
@@ -2410,7 +3738,7 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                         mpq_div(tmp, lh.v._bigrat, tmp);
                         if (mpz_cmp_ui(mpq_denref(tmp),1) != 0) {
                                 mpq_set(lh.v._bigrat, tmp);
-                                lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                                lh.hash = hash_pending;
                                 mpq_clear(tmp);
                                 return lh;
                         }
@@ -2418,7 +3746,7 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                         lh.t = MPZ;
                         mpz_init(lh.v._bigint);
                         mpz_set(lh.v._bigint, mpq_numref(tmp));
-                        lh.hash = _mpz_pythonhash(lh.v._bigint);
+                        lh.hash = hash_pending;
                         mpq_clear(tmp);
                         return lh;
                 }
@@ -2437,7 +3765,7 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                 auto ld = std::div(lh.v._long, rh.v._long);
                 if (ld.rem == 0) {
                         lh.v._long = ld.quot;
-                        lh.hash = (ld.quot == -1) ? -2 : ld.quot;
+                        lh.hash = _long_pythonhash(ld.quot);
                         return lh;
                 }
 
@@ -2454,7 +3782,7 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                 if (sign == -1)
                         mpq_neg(lh.v._bigrat, lh.v._bigrat);
                 mpq_clear(obigrat);
-                lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                lh.hash = hash_pending;
                 return lh;
         }
         case MPZ: {
@@ -2462,7 +3790,7 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                         mpz_divexact(lh.v._bigint,
                         lh.v._bigint,
                         rh.v._bigint);
-                        lh.hash = _mpz_pythonhash(lh.v._bigint);
+                        lh.hash = hash_pending;
                         return lh;
                 }
                 mpq_t bigrat, obigrat;
@@ -2474,14 +3802,26 @@ numeric & operator/=(numeric & lh, const numeric & rh)
                 lh.t = MPQ;
                 mpq_init(lh.v._bigrat);
                 mpq_div(lh.v._bigrat, bigrat, obigrat);
-                lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                lh.hash = hash_pending;
                 mpq_clear(bigrat);
                 mpq_clear(obigrat);
                 return lh;
         }
         case MPQ:
                 mpq_div(lh.v._bigrat, lh.v._bigrat, rh.v._bigrat);
-                lh.hash = _mpq_pythonhash(lh.v._bigrat);
+                lh.hash = hash_pending;
+                return lh;
+        case MPFR:
+                lh = mpfr_apply(mpfr_div, lh.v._bigfloat, rh.v._bigfloat);
+                return lh;
+        case MPFC:
+                lh = mpfc_apply(mpfc_div, lh.v._bigcomplex, rh.v._bigcomplex);
+                return lh;
+        case MPQC:
+                lh = mpqc_apply(mpqc_div, lh.v._gaussrat, rh.v._gaussrat);
+                return lh;
+        case ACB:
+                lh = ball_apply(acb_div, lh.v._ball, rh.v._ball);
                 return lh;
         case PYOBJECT: {
                 PyObject *p = lh.v._pyobject;
@@ -2578,6 +3918,14 @@ const numeric numeric::step() const {
                         return 1;
                 else
                         return 0;
+        case MPFR:
+                return mpfr_sgn(v._bigfloat) > 0 ? 1 : 0;
+        case MPFC:
+                return mpfr_sgn(v._bigcomplex->re) > 0 ? 1 : 0;
+        case MPQC:
+                return mpq_sgn(v._gaussrat->re) > 0 ? 1 : 0;
+        case ACB:
+                return arb_is_positive(acb_realref(&v._ball->z)) != 0 ? 1 : 0;
         case PYOBJECT:
                 return py_funcs.py_step(v._pyobject);
         default:
@@ -2601,6 +3949,24 @@ int numeric::csgn() const {
                 return mpz_sgn(v._bigint);
         case MPQ:
                 return mpq_sgn(v._bigrat);
+        case MPFR:
+                return mpfr_sgn(v._bigfloat);
+        case MPFC:
+                if (mpfr_zero_p(v._bigcomplex->re) == 0)
+                        return mpfr_sgn(v._bigcomplex->re) > 0 ? 1 : -1;
+                return mpfr_sgn(v._bigcomplex->im) > 0 ? 1
+                        : (mpfr_sgn(v._bigcomplex->im) < 0 ? -1 : 0);
+        case MPQC:
+                if (mpq_sgn(v._gaussrat->re) != 0)
+                        return mpq_sgn(v._gaussrat->re);
+                return mpq_sgn(v._gaussrat->im);
+        case ACB: {
+                // by the midpoint
+                arf_srcptr re = arb_midref(acb_realref(&v._ball->z));
+                if (arf_is_zero(re) == 0)
+                        return arf_sgn(re);
+                return arf_sgn(arb_midref(acb_imagref(&v._ball->z)));
+        }
         case PYOBJECT: {
                 int result;
                 if (is_real()) {
@@ -2638,6 +4004,15 @@ bool numeric::is_zero() const {
                 return mpz_cmp_si(v._bigint, 0) == 0;
         case MPQ:
                 return mpq_cmp_si(v._bigrat, 0, 1) == 0;
+        case MPFR:
+                return mpfr_zero_p(v._bigfloat) != 0;
+        case MPFC:
+                return mpfr_zero_p(v._bigcomplex->re) != 0
+                        and mpfr_zero_p(v._bigcomplex->im) != 0;
+        case MPQC:
+                return false;
+        case ACB:
+                return acb_is_zero(&v._ball->z) != 0;
         case PYOBJECT:
                 a = PyObject_Not(v._pyobject);
                 if (a == -1)
@@ -2658,6 +4033,15 @@ bool numeric::is_inexact_one() const {
                 return mpz_cmp_si(v._bigint, 1) == 0;
         case MPQ:
                 return mpq_cmp_si(v._bigrat, 1, 1) == 0;
+        case MPFR:
+                return mpfr_cmp_si(v._bigfloat, 1) == 0;
+        case MPFC:
+                return mpfr_cmp_si(v._bigcomplex->re, 1) == 0
+                        and mpfr_zero_p(v._bigcomplex->im) != 0;
+        case MPQC:
+                return false;
+        case ACB:
+                return acb_is_one(&v._ball->z) != 0;
         case PYOBJECT:
                 return is_equal(*_num1_p);
         default:
@@ -2675,6 +4059,11 @@ bool numeric::is_one() const {
                 return mpz_cmp_si(v._bigint, 1) == 0;
         case MPQ:
                 return mpq_cmp_si(v._bigrat, 1, 1) == 0;
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return is_exact() and is_equal(*_num1_p);
         default:
@@ -2692,6 +4081,11 @@ bool numeric::is_minus_one() const {
                 return mpz_cmp_si(v._bigint, -1) == 0;
         case MPQ:
                 return mpq_cmp_si(v._bigrat, -1, 1) == 0;
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return is_exact() and is_equal(*_num_1_p);
         default:
@@ -2710,6 +4104,14 @@ bool numeric::is_positive() const {
                 return mpz_cmp_si(v._bigint, 0) > 0;
         case MPQ:
                 return mpq_cmp_si(v._bigrat, 0, 1) > 0;
+        case MPFR:
+                return mpfr_sgn(v._bigfloat) > 0;
+        case MPFC:
+        case MPQC:
+                return false;
+        case ACB:
+                return acb_is_real(&v._ball->z) != 0
+                        and arb_is_positive(acb_realref(&v._ball->z)) != 0;
         case PYOBJECT:
                 if (is_real()) {
                         int result;
@@ -2736,6 +4138,14 @@ bool numeric::is_negative() const {
                 return mpz_cmp_si(v._bigint, 0) < 0;
         case MPQ:
                 return mpq_cmp_si(v._bigrat, 0, 1) < 0;
+        case MPFR:
+                return mpfr_sgn(v._bigfloat) < 0;
+        case MPFC:
+        case MPQC:
+                return false;
+        case ACB:
+                return acb_is_real(&v._ball->z) != 0
+                        and arb_is_negative(acb_realref(&v._ball->z)) != 0;
         case PYOBJECT:
                 if (is_real()) {
                         int result;
@@ -2770,6 +4180,11 @@ bool numeric::is_integer() const {
                 mpq_clear(bigrat);
                 return ret;
         }
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return py_funcs.py_is_integer(v._pyobject) != 0;
         default:
@@ -2787,6 +4202,11 @@ bool numeric::is_pos_integer() const {
                 return is_positive();
         case MPQ:
                 return (is_integer() && is_positive());
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return (is_integer() && is_positive());
         default:
@@ -2804,6 +4224,11 @@ bool numeric::is_nonneg_integer() const {
                 return is_positive() or is_zero();
         case MPQ:
                 return (is_integer() and (is_positive() or is_zero()));
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 if (is_integer()) {
                         int result;
@@ -2852,6 +4277,11 @@ bool numeric::is_odd() const {
         case MPQ:
                 return is_integer()
                 and mpz_tstbit(mpq_numref(v._bigrat), 0) == 1;
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return !is_even();
         default:
@@ -2877,6 +4307,11 @@ bool numeric::is_prime() const {
         case MPQ:
                 return is_integer()
                         and mpz_probab_prime_p(mpq_numref(v._bigrat), 25) > 0;
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return py_funcs.py_is_prime(v._pyobject) != 0;
         default:
@@ -2893,6 +4328,10 @@ bool numeric::is_rational() const {
         case MPZ:
         case MPQ:
                 return true;
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
         case PYOBJECT:
                 return false;
         default:
@@ -2907,7 +4346,14 @@ bool numeric::is_real() const {
         case LONG:
         case MPZ:
         case MPQ:
+        case MPFR:
                 return true;
+        case MPFC:
+                return mpfr_zero_p(v._bigcomplex->im) != 0;
+        case MPQC:
+                return false;
+        case ACB:
+                return acb_is_real(&v._ball->z) != 0;
         case PYOBJECT:
                 return py_funcs.py_is_real(v._pyobject) != 0;
         default:
@@ -2923,7 +4369,12 @@ bool numeric::is_exact() const {
         case LONG:
         case MPZ:
         case MPQ:
+        case MPQC:
                 return true;
+        case MPFR:
+        case MPFC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return py_funcs.py_is_exact(v._pyobject) != 0;
         default:
@@ -2964,6 +4415,10 @@ bool numeric::is_small_power(std::pair<int,int>& p) const
                         return false;
                 break;
         case MPQ:
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
         case PYOBJECT:
                 return false;
         default:
@@ -3009,6 +4464,20 @@ bool numeric::operator==(const numeric &right) const {
                 return mpz_cmp(v._bigint, right.v._bigint) == 0;
         case MPQ:
                 return mpq_equal(v._bigrat, right.v._bigrat) != 0;
+        case MPFR:
+                return mpfr_equal_p(v._bigfloat, right.v._bigfloat) != 0;
+        case MPFC:
+                return mpfr_equal_p(v._bigcomplex->re,
+                                right.v._bigcomplex->re) != 0
+                        and mpfr_equal_p(v._bigcomplex->im,
+                                right.v._bigcomplex->im) != 0;
+        case MPQC:
+                return mpq_equal(v._gaussrat->re, right.v._gaussrat->re) != 0
+                        and mpq_equal(v._gaussrat->im,
+                                right.v._gaussrat->im) != 0;
+        case ACB:
+                // same midpoint and radius
+                return acb_equal(&v._ball->z, &right.v._ball->z) != 0;
         case PYOBJECT:
                 if (v._pyobject == right.v._pyobject)
                         return true;
@@ -3047,6 +4516,12 @@ bool numeric::operator!=(const numeric &right) const {
                 return mpz_cmp(v._bigint, right.v._bigint) != 0;
         case MPQ:
                 return mpq_equal(v._bigrat, right.v._bigrat) == 0;
+        case MPFR:
+                return mpfr_equal_p(v._bigfloat, right.v._bigfloat) == 0;
+        case MPFC:
+        case MPQC:
+        case ACB:
+                return not (*this == right);
         case PYOBJECT:
                 return (py_funcs.py_is_equal(v._pyobject,
                                         right.v._pyobject) == 0);
@@ -3065,6 +4540,13 @@ bool numeric::is_cinteger() const {
                 return true;
         case MPQ:
                 return is_integer();
+        case MPFR:
+        case MPFC:
+        case ACB:
+                return false;
+        case MPQC:
+                return mpz_cmp_ui(mpq_denref(v._gaussrat->re), 1) == 0
+                        and mpz_cmp_ui(mpq_denref(v._gaussrat->im), 1) == 0;
         case PYOBJECT:
                 return real().is_integer()
                 and imag().is_integer();
@@ -3081,7 +4563,12 @@ bool numeric::is_crational() const {
         case LONG:
         case MPZ:
         case MPQ:
+        case MPQC:
                 return true;
+        case MPFR:
+        case MPFC:
+        case ACB:
+                return false;
         case PYOBJECT:
                 return real().is_rational()
                 and imag().is_rational();
@@ -3090,7 +4577,23 @@ bool numeric::is_crational() const {
         }
 }
 
-/** Numerical comparison: less.
+// Complex floats and Gaussian rationals are ordered by Python, as they
+// were before they had a native representation.
+static bool py_richcompare(const numeric& a, const numeric& b, int op)
+{
+        PyObject* aa = a.to_pyobject();
+        PyObject* bb = b.to_pyobject();
+        int result = PyObject_RichCompareBool(aa, bb, op);
+        Py_DECREF(aa);
+        Py_DECREF(bb);
+        if (result == -1)
+                py_error("richcmp failed");
+        return result == 1;
+}
+
+/** Numerical comparison: less.  Balls compare as less only if every
+ *  number in the left one is less than every number in the right one,
+ *  and similarly for the other comparisons.
  *
  *  @exception invalid_argument (complex inequality) */
 bool numeric::operator<(const numeric &right) const {
@@ -3112,6 +4615,16 @@ bool numeric::operator<(const numeric &right) const {
                 return mpz_cmp(v._bigint, right.v._bigint) < 0;
         case MPQ:
                 return mpq_cmp(v._bigrat, right.v._bigrat) < 0;
+        case MPFR:
+                return mpfr_less_p(v._bigfloat, right.v._bigfloat) != 0;
+        case MPFC:
+        case MPQC:
+                return py_richcompare(*this, right, Py_LT);
+        case ACB:
+                if (not is_real() or not right.is_real())
+                        throw std::invalid_argument("numeric: complex inequality");
+                return arb_lt(acb_realref(&v._ball->z),
+                                acb_realref(&right.v._ball->z)) != 0;
         case PYOBJECT: {
                 int result;
                 result = PyObject_RichCompareBool(v._pyobject,
@@ -3147,6 +4660,16 @@ bool numeric::operator<=(const numeric &right) const {
                 return mpz_cmp(v._bigint, right.v._bigint) <= 0;
         case MPQ:
                 return mpq_cmp(v._bigrat, right.v._bigrat) <= 0;
+        case MPFR:
+                return mpfr_lessequal_p(v._bigfloat, right.v._bigfloat) != 0;
+        case MPFC:
+        case MPQC:
+                return py_richcompare(*this, right, Py_LE);
+        case ACB:
+                if (not is_real() or not right.is_real())
+                        throw std::invalid_argument("numeric: complex inequality");
+                return arb_le(acb_realref(&v._ball->z),
+                                acb_realref(&right.v._ball->z)) != 0;
         case PYOBJECT:
                 int result;
                 result = PyObject_RichCompareBool(v._pyobject,
@@ -3181,6 +4704,16 @@ bool numeric::operator>(const numeric &right) const {
                 return mpz_cmp(v._bigint, right.v._bigint) > 0;
         case MPQ:
                 return mpq_cmp(v._bigrat, right.v._bigrat) > 0;
+        case MPFR:
+                return mpfr_greater_p(v._bigfloat, right.v._bigfloat) != 0;
+        case MPFC:
+        case MPQC:
+                return py_richcompare(*this, right, Py_GT);
+        case ACB:
+                if (not is_real() or not right.is_real())
+                        throw std::invalid_argument("numeric: complex inequality");
+                return arb_gt(acb_realref(&v._ball->z),
+                                acb_realref(&right.v._ball->z)) != 0;
         case PYOBJECT:
                 int result;
                 result = PyObject_RichCompareBool(v._pyobject,
@@ -3215,6 +4748,16 @@ bool numeric::operator>=(const numeric &right) const {
                 return mpz_cmp(v._bigint, right.v._bigint) >= 0;
         case MPQ:
                 return mpq_cmp(v._bigrat, right.v._bigrat) >= 0;
+        case MPFR:
+                return mpfr_greaterequal_p(v._bigfloat, right.v._bigfloat) != 0;
+        case MPFC:
+        case MPQC:
+                return py_richcompare(*this, right, Py_GE);
+        case ACB:
+                if (not is_real() or not right.is_real())
+                        throw std::invalid_argument("numeric: complex inequality");
+                return arb_ge(acb_realref(&v._ball->z),
+                                acb_realref(&right.v._ball->z)) != 0;
         case PYOBJECT:
                 int result;
                 result = PyObject_RichCompareBool(v._pyobject,
@@ -3253,6 +4796,10 @@ int numeric::to_int() const
                 mpz_clear(bigint);
                 throw conversion_error();
         }
+        case MPFR:
+                if (mpfr_fits_sint_p(v._bigfloat, MPFR_RNDD) != 0)
+                        return mpfr_get_si(v._bigfloat, MPFR_RNDD);
+                throw conversion_error();
         case PYOBJECT:
                 return to_bigint().to_int();
         default:
@@ -3284,6 +4831,10 @@ long numeric::to_long() const {
                 mpz_clear(bigint);
                 throw conversion_error();
         }
+        case MPFR:
+                if (mpfr_fits_slong_p(v._bigfloat, MPFR_RNDD) != 0)
+                        return mpfr_get_si(v._bigfloat, MPFR_RNDD);
+                throw conversion_error();
         case PYOBJECT:
                 return to_bigint().to_long();
         default:
@@ -3298,7 +4849,7 @@ const numeric numeric::to_bigint() const {
                 numeric nu;
                 mpz_init_set_si(nu.v._bigint, v._long);
                 nu.t = MPZ;
-                nu.hash = _mpz_pythonhash(nu.v._bigint);
+                nu.hash = hash_pending;
                 return nu;
         }
         case MPZ: return *this;
@@ -3306,6 +4857,14 @@ const numeric numeric::to_bigint() const {
                 if (not denom().is_one())
                         throw std::runtime_error("not integer in numeric::to_mpz_num()");
                 return numer();
+        case MPFR: {
+                if (mpfr_number_p(v._bigfloat) == 0)
+                        throw conversion_error();
+                mpz_t bigint;
+                mpz_init(bigint);
+                mpfr_get_z(bigint, v._bigfloat, MPFR_RNDZ);
+                return bigint;
+        }
         case PYOBJECT: {
                 PyObject *Integer = Integer_pyclass();
                 PyObject *ans = PyObject_CallFunctionObjArgs(Integer,
@@ -3331,8 +4890,32 @@ const mpq_t& numeric::as_mpq() const
         return v._bigrat;
 }
 
+const mpfr_t& numeric::as_mpfr() const
+{
+        if (t != MPFR)
+                throw std::runtime_error("mpfr_t requested from non-mpfr numeric");
+        return v._bigfloat;
+}
+
+ball_srcptr numeric::as_ball() const
+{
+        if (t != ACB)
+                throw std::runtime_error("ball requested from non-ball numeric");
+        return v._ball;
+}
+
 void numeric::canonicalize()
 {
+        if (t == MPZ) {
+                if (mpz_fits_slong_p(v._bigint)) {
+                        long l = mpz_get_si(v._bigint);
+                        mpz_clear(v._bigint);
+                        t = LONG;
+                        v._long = l;
+                        hash = (l == -1) ? -2 : l;
+                }
+                return;
+        }
         if (t == MPQ) {
                 mpq_canonicalize(v._bigrat);
                 if (mpz_cmp_ui(mpq_denref(v._bigrat), 1) == 0) {
@@ -3430,6 +5013,14 @@ PyObject* numeric::to_pyobject() const {
                 mpq_clear(bigrat);
                 return o;
         }
+        case MPFR:
+                return mpfr_to_pyobject(v._bigfloat);
+        case MPFC:
+                return mpfc_to_pyobject(v._bigcomplex);
+        case MPQC:
+                return mpqc_to_pyobject(v._gaussrat);
+        case ACB:
+                return ball_to_pyobject(v._ball);
         case PYOBJECT:
                 Py_INCREF(v._pyobject);
                 return v._pyobject;
@@ -3455,6 +5046,11 @@ double numeric::to_double() const {
                 return mpz_get_d(v._bigint);
         case MPQ:
                 return mpq_get_d(v._bigrat);
+        case MPFR:
+                return mpfr_get_d(v._bigfloat, MPFR_RNDN);
+        case ACB:
+                return arf_get_d(arb_midref(acb_realref(&v._ball->z)),
+                                ARF_RND_NEAR);
         case PYOBJECT:
                 d = PyFloat_AsDouble(v._pyobject);
                 if (d == -1 && (PyErr_Occurred() != nullptr))
@@ -3476,11 +5072,30 @@ ex numeric::eval(int /*level*/) const {
 /** Cast numeric into a floating-point object.  For example exact numeric(1) is
  *  returned as a 1.0000000000000000000000 and so on according to how Digits is
  *  currently set.  In case the object already was a floating point number the
- *  precision is trimmed to match the currently set default.
+ *  precision is trimmed to match the currently set default.  Without a
+ *  parent, real and complex numbers become native MPFR floats if a
+ *  precision was set with set_evalf_mpfr_precision(), and balls are
+ *  returned unchanged.
  *
  *  @param level  ignored, only needed for overriding basic::evalf.
  *  @return  an ex-handle to a numeric. */
 ex numeric::evalf(int /*level*/, PyObject* parent) const {
+        if (parent == nullptr and t == ACB)
+                return *this;
+        if (parent == nullptr and evalf_mpfr_prec > 0
+            and (t == MPFR or is_rational())) {
+                mpfr_t bigfloat;
+                mpfr_init2(bigfloat, evalf_mpfr_prec);
+                mpfr_set_numeric(bigfloat, *this);
+                return numeric(bigfloat);
+        }
+        if (parent == nullptr and evalf_mpfr_prec > 0
+            and (t == MPFC or t == MPQC)) {
+                mpfc_ptr bigcomplex;
+                mpfc_init2(bigcomplex, evalf_mpfr_prec);
+                mpfc_set_numeric(bigcomplex, *this);
+                return numeric(bigcomplex);
+        }
         PyObject *ans, *a = to_pyobject();
         if (parent == nullptr)
                 parent = RR_get();
@@ -3503,6 +5118,31 @@ ex numeric::evalf(int /*level*/, PyObject* parent) const {
         return ans;
 }
 
+/** Enclose the number in a ball with a working precision of prec bits.
+ *  Floats, including Python floats and complex numbers, are the exact
+ *  midpoint of the ball.
+ *
+ *  @exception domain_error (other Python objects) */
+const numeric numeric::to_ball(long prec) const
+{
+        if (prec < 2)
+                throw std::invalid_argument("numeric::to_ball(): invalid precision");
+        ball_ptr ball;
+        ball_init(ball, prec);
+        if (t != PYOBJECT)
+                ball_set_numeric(ball, *this);
+        else if (PyFloat_Check(v._pyobject))
+                acb_set_d(&ball->z, PyFloat_AsDouble(v._pyobject));
+        else if (PyComplex_Check(v._pyobject))
+                acb_set_d_d(&ball->z, PyComplex_RealAsDouble(v._pyobject),
+                                PyComplex_ImagAsDouble(v._pyobject));
+        else {
+                ball_clear(ball);
+                throw std::domain_error("numeric::to_ball(): cannot enclose Python object");
+        }
+        return ball;
+}
+
 const numeric numeric::try_py_method(const std::string& s) const
 {
         PyObject *obj = to_pyobject();
@@ -3627,7 +5267,22 @@ const numeric numeric::real() const {
         case LONG:
         case MPZ:
         case MPQ:
+        case MPFR:
                 return *this;
+        case MPFC: {
+                mpfr_t bigfloat;
+                mpfr_init2(bigfloat, mpfc_get_prec(v._bigcomplex));
+                mpfr_set(bigfloat, v._bigcomplex->re, MPFR_RNDN);
+                return bigfloat;
+        }
+        case MPQC: {
+                mpq_t bigrat;
+                mpq_init(bigrat);
+                mpq_set(bigrat, v._gaussrat->re);
+                return bigrat;
+        }
+        case ACB:
+                return ball_from_arb(acb_realref(&v._ball->z), v._ball->prec);
         case PYOBJECT:
         {
                 if (PyFloat_Check(v._pyobject))
@@ -3655,7 +5310,22 @@ const numeric numeric::imag() const {
         case LONG:
         case MPZ:
         case MPQ:
+        case MPFR:
                 return *_num0_p;
+        case MPFC: {
+                mpfr_t bigfloat;
+                mpfr_init2(bigfloat, mpfc_get_prec(v._bigcomplex));
+                mpfr_set(bigfloat, v._bigcomplex->im, MPFR_RNDN);
+                return bigfloat;
+        }
+        case MPQC: {
+                mpq_t bigrat;
+                mpq_init(bigrat);
+                mpq_set(bigrat, v._gaussrat->im);
+                return bigrat;
+        }
+        case ACB:
+                return ball_from_arb(acb_imagref(&v._ball->z), v._ball->prec);
         case PYOBJECT:
         {
                 if (PyFloat_Check(v._pyobject))
@@ -3686,12 +5356,17 @@ const numeric numeric::numer() const {
         switch (t) {
         case LONG:
         case MPZ:
+        case MPFR:
+        case MPFC:
+        case ACB:
                 return *this;
         case MPQ: {
                 mpz_t bigint;
                 mpz_init_set(bigint, mpq_numref(v._bigrat));
                 return bigint;
         }
+        case MPQC:
+                return *this * denom();
         case PYOBJECT: {
                 PyObject *a;
                 a = py_funcs.py_numer(v._pyobject);
@@ -3711,12 +5386,22 @@ const numeric numeric::denom() const {
         switch (t) {
         case LONG:
         case MPZ:
+        case MPFR:
+        case MPFC:
+        case ACB:
                 return 1;
         case MPQ: {
                 mpz_t bigint;
                 mpz_init_set(bigint, mpq_denref(v._bigrat));
                 return bigint;
         }
+        case MPQC: {
+                mpz_t bigint;
+                mpz_init(bigint);
+                mpz_lcm(bigint, mpq_denref(v._gaussrat->re),
+                                mpq_denref(v._gaussrat->im));
+                return bigint;
+        }
         case PYOBJECT: {
                 PyObject *a;
                 a = py_funcs.py_denom(v._pyobject);
@@ -3729,6 +5414,22 @@ const numeric numeric::denom() const {
 }
 
 const numeric numeric::floor() const {
+        if (t == MPFR) {
+                if (mpfr_number_p(v._bigfloat) == 0)
+                        return *this;
+                mpz_t bigint;
+                mpz_init(bigint);
+                mpfr_get_z(bigint, v._bigfloat, MPFR_RNDD);
+                return bigint;
+        }
+        if (t == ACB and is_real()) {
+                arb_t x;
+                arb_init(x);
+                arb_floor(x, acb_realref(&v._ball->z), v._ball->prec);
+                numeric ret = ball_from_arb(x, v._ball->prec);
+                arb_clear(x);
+                return ret;
+        }
         numeric d = denom();
         if (d.is_one())
                 return *this;
@@ -3736,6 +5437,8 @@ const numeric numeric::floor() const {
 }
 
 const numeric numeric::frac() const {
+        if (t == MPFR or (t == ACB and is_real()))
+                return *this - floor();
         numeric d = denom();
         if (d.is_one())
                 return 0;
@@ -3747,6 +5450,10 @@ const numeric numeric::fibonacci() const {
 }
 
 const numeric numeric::exp(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_exp, v._ball);
+        if (t == MPFR and parent == nullptr)
+                return mpfr_apply(mpfr_exp, v._bigfloat);
         static numeric tentt20 = ex_to<numeric>(_num10_p->power(*_num20_p));
         // avoid Flint aborts
         if (real() > tentt20) {
@@ -3762,6 +5469,10 @@ const numeric numeric::exp(PyObject* parent) const {
 }
 
 const numeric numeric::log(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_log, v._ball);
+        if (t == MPFR and parent == nullptr and mpfr_sgn(v._bigfloat) >= 0)
+                return mpfr_apply(mpfr_log, v._bigfloat);
         return arbfunc_0arg("log", parent);
 }
 
@@ -3872,30 +5583,80 @@ const numeric numeric::ratlog(const numeric &b, bool& israt) const {
 }
 
 const numeric numeric::sin() const {
+        if (t == ACB)
+                return ball_apply(acb_sin, v._ball);
+        if (t == MPFR)
+                return mpfr_apply(mpfr_sin, v._bigfloat);
         PY_RETURN(py_funcs.py_sin);
 }
 
 const numeric numeric::cos() const {
+        if (t == ACB)
+                return ball_apply(acb_cos, v._ball);
+        if (t == MPFR)
+                return mpfr_apply(mpfr_cos, v._bigfloat);
         PY_RETURN(py_funcs.py_cos);
 }
 
 const numeric numeric::tan() const {
+        if (t == ACB)
+                return ball_apply(acb_tan, v._ball);
+        if (t == MPFR)
+                return mpfr_apply(mpfr_tan, v._bigfloat);
         PY_RETURN(py_funcs.py_tan);
 }
 
 const numeric numeric::asin(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_asin, v._ball);
+        if (t == MPFR and parent == nullptr
+            and mpfr_cmp_si(v._bigfloat, -1) >= 0
+            and mpfr_cmp_si(v._bigfloat, 1) <= 0)
+                return mpfr_apply(mpfr_asin, v._bigfloat);
         return arbfunc_0arg("arcsin", parent);
 }
 
 const numeric numeric::acos(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_acos, v._ball);
+        if (t == MPFR and parent == nullptr
+            and mpfr_cmp_si(v._bigfloat, -1) >= 0
+            and mpfr_cmp_si(v._bigfloat, 1) <= 0)
+                return mpfr_apply(mpfr_acos, v._bigfloat);
         return arbfunc_0arg("arccos", parent);
 }
 
 const numeric numeric::atan(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_atan, v._ball);
+        if (t == MPFR and parent == nullptr)
+                return mpfr_apply(mpfr_atan, v._bigfloat);
         return arbfunc_0arg("arctan", parent);
 }
 
 const numeric numeric::atan(const numeric& y, PyObject* parent) const {
+        if ((t == ACB or y.t == ACB) and t != PYOBJECT and y.t != PYOBJECT
+            and is_real() and y.is_real()) {
+                numeric a, b;
+                coerce(a, b, y, *this);
+                arb_t x;
+                arb_init(x);
+                slong prec = std::min(a.v._ball->prec, b.v._ball->prec);
+                arb_atan2(x, acb_realref(&a.v._ball->z),
+                                acb_realref(&b.v._ball->z), prec);
+                numeric ret = ball_from_arb(x, prec);
+                arb_clear(x);
+                return ret;
+        }
+        if (parent == nullptr and (t == MPFR or y.t == MPFR)
+            and (t == MPFR or is_rational())
+            and (y.t == MPFR or y.is_rational())) {
+                if (is_zero() and y.is_zero())
+                        throw (std::runtime_error("atan2(): division by zero"));
+                numeric a, b;
+                coerce(a, b, y, *this);
+                return mpfr_apply(mpfr_atan2, a.v._bigfloat, b.v._bigfloat);
+        }
         PyObject *cparent = common_parent(*this, y);
         bool newdict = false;
         if (parent == nullptr) {
@@ -3939,28 +5700,55 @@ const numeric numeric::atan(const numeric& y, PyObject* parent) const {
 }
 
 const numeric numeric::sinh(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_sinh, v._ball);
+        if (t == MPFR and parent == nullptr)
+                return mpfr_apply(mpfr_sinh, v._bigfloat);
         return (exp(parent) - negative().exp(parent)) / *_num2_p;
 }
 
 const numeric numeric::cosh(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_cosh, v._ball);
+        if (t == MPFR and parent == nullptr)
+                return mpfr_apply(mpfr_cosh, v._bigfloat);
         return (exp(parent) + negative().exp(parent)) / *_num2_p;
 }
 
 const numeric numeric::tanh(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_tanh, v._ball);
+        if (t == MPFR and parent == nullptr)
+                return mpfr_apply(mpfr_tanh, v._bigfloat);
         const numeric& e2x = exp(parent);
         const numeric& e2nx = negative().exp(parent);
         return (e2x - e2nx)/(e2x + e2nx);
 }
 
 const numeric numeric::asinh(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_asinh, v._ball);
+        if (t == MPFR and parent == nullptr)
+                return mpfr_apply(mpfr_asinh, v._bigfloat);
         return arbfunc_0arg("arcsinh", parent);
 }
 
 const numeric numeric::acosh(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_acosh, v._ball);
+        if (t == MPFR and parent == nullptr
+            and mpfr_cmp_si(v._bigfloat, 1) >= 0)
+                return mpfr_apply(mpfr_acosh, v._bigfloat);
         return arbfunc_0arg("arccosh", parent);
 }
 
 const numeric numeric::atanh(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_atanh, v._ball);
+        if (t == MPFR and parent == nullptr
+            and mpfr_cmp_si(v._bigfloat, -1) > 0
+            and mpfr_cmp_si(v._bigfloat, 1) < 0)
+                return mpfr_apply(mpfr_atanh, v._bigfloat);
         int prec = precision(*this, parent);
         PyObject* field = CBF(prec+15);
         PyObject* ret = CallBallMethod0Arg(field, const_cast<char*>("arctanh"), *this);
@@ -3975,6 +5763,12 @@ const numeric numeric::atanh(PyObject* parent) const {
 }
 
 const numeric numeric::Li2(const numeric &n, PyObject* parent) const {
+        if (t == ACB and n.is_integer() and n.t != PYOBJECT) {
+                ball_ptr ball;
+                ball_init(ball, v._ball->prec);
+                acb_polylog_si(&ball->z, n.to_long(), &v._ball->z, ball->prec);
+                return ball;
+        }
         PyObject *cparent = common_parent(*this, n);
         if (parent == nullptr)
                parent = cparent;
@@ -3994,6 +5788,10 @@ const numeric numeric::Li2(const numeric &n, PyObject* parent) const {
 }
 
 const numeric numeric::lgamma(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_lgamma, v._ball);
+        if (t == MPFR and parent == nullptr and mpfr_sgn(v._bigfloat) > 0)
+                return mpfr_apply(mpfr_lngamma, v._bigfloat);
         int prec = precision(*this, parent);
         PyObject* field = CBF(prec+15);
         PyObject* ret = CallBallMethod0Arg(field, const_cast<char*>("log_gamma"), *this);
@@ -4004,14 +5802,26 @@ const numeric numeric::lgamma(PyObject* parent) const {
 }
 
 const numeric numeric::gamma(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_gamma, v._ball);
+        if (t == MPFR and parent == nullptr
+            and (mpfr_sgn(v._bigfloat) > 0
+                 or mpfr_integer_p(v._bigfloat) == 0))
+                return mpfr_apply(mpfr_gamma, v._bigfloat);
         return arbfunc_0arg("gamma", parent);
 }
 
 const numeric numeric::rgamma(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_rgamma, v._ball);
         return arbfunc_0arg("rgamma", parent);
 }
 
 const numeric numeric::psi(PyObject* parent) const {
+        if (t == ACB)
+                return ball_apply(acb_digamma, v._ball);
+        if (t == MPFR and parent == nullptr and mpfr_sgn(v._bigfloat) > 0)
+                return mpfr_apply(mpfr_digamma, v._bigfloat);
         return arbfunc_0arg("psi", parent);
 }
 
@@ -4020,6 +5830,10 @@ const numeric numeric::psi(const numeric& y) const {
 }
 
 const numeric numeric::zeta() const {
+        if (t == ACB)
+                return ball_apply(acb_zeta, v._ball);
+        if (t == MPFR)
+                return mpfr_apply(mpfr_zeta, v._bigfloat);
         PY_RETURN(py_funcs.py_zeta);
 }
 
@@ -4168,6 +5982,10 @@ const numeric numeric::isqrt() const {
 }
 
 const numeric numeric::sqrt() const {
+        if (t == ACB)
+                return ball_apply(acb_sqrt, v._ball);
+        if (t == MPFR and mpfr_sgn(v._bigfloat) >= 0)
+                return mpfr_apply(mpfr_sqrt, v._bigfloat);
         PY_RETURN(py_funcs.py_sqrt);
 }
 
@@ -4238,6 +6056,10 @@ const ex numeric::sqrt_as_ex() const
                 }
                 break;
         }
+        case MPFR:
+        case MPFC:
+        case MPQC:
+        case ACB:
         case PYOBJECT:
                 return sqrt();
         default:
@@ -4264,6 +6086,31 @@ const numeric numeric::abs() const {
                 mpq_abs(bigrat, v._bigrat);
                 return bigrat;
         }
+        case MPFR:
+                return mpfr_apply(mpfr_abs, v._bigfloat);
+        case MPFC: {
+                mpfr_t bigfloat;
+                mpfr_init2(bigfloat, mpfc_get_prec(v._bigcomplex));
+                mpfr_hypot(bigfloat, v._bigcomplex->re, v._bigcomplex->im,
+                                MPFR_RNDN);
+                return bigfloat;
+        }
+        case ACB: {
+                arb_t x;
+                arb_init(x);
+                acb_abs(x, &v._ball->z, v._ball->prec);
+                numeric ret = ball_from_arb(x, v._ball->prec);
+                arb_clear(x);
+                return ret;
+        }
+        case MPQC: {
+                PyObject *obj = to_pyobject();
+                PyObject *ret = PyNumber_Absolute(obj);
+                Py_DECREF(obj);
+                if (ret == NULL)
+                        py_error("numeric::abs");
+                return ret;
+        }
         case PYOBJECT: {
                 PyObject *ret = PyNumber_Absolute(v._pyobject);
                 if (ret == NULL) {
@@ -4669,6 +6516,78 @@ void coerce(numeric& new_left, numeric& new_right, const numeric& left, const nu
                 new_right = right;
                 return;
         }
+        // Native floats, complex numbers and balls become Sage elements
+        // next to any other PyObject.
+        if ((left.t == PYOBJECT or right.t == PYOBJECT)
+            and (left.t == MPFR or left.t == MPFC or left.t == MPQC
+                 or left.t == ACB
+                 or right.t == MPFR or right.t == MPFC or right.t == MPQC
+                 or right.t == ACB)) {
+                const numeric& x = (left.t == PYOBJECT) ? right : left;
+                numeric& new_x = (left.t == PYOBJECT) ? new_right : new_left;
+                numeric& new_p = (left.t == PYOBJECT) ? new_left : new_right;
+                new_p = (left.t == PYOBJECT) ? left : right;
+                new_x = numeric(x.to_pyobject(), true);
+                return;
+        }
+        // Any other number next to a ball is enclosed in a ball of the
+        // same precision.
+        if (left.t == ACB or right.t == ACB) {
+                const numeric& b = (left.t == ACB) ? left : right;
+                const numeric& x = (left.t == ACB) ? right : left;
+                numeric& new_b = (left.t == ACB) ? new_left : new_right;
+                numeric& new_x = (left.t == ACB) ? new_right : new_left;
+                ball_ptr ball;
+                ball_init(ball, b.v._ball->prec);
+                ball_set_numeric(ball, x);
+                new_x = numeric(ball);
+                new_b = b;
+                return;
+        }
+        // Anything next to a complex float, and a float next to a Gaussian
+        // rational, become complex floats of the lower float precision.
+        if (left.t == MPFC or right.t == MPFC
+            or ((left.t == MPFR or right.t == MPFR)
+                and (left.t == MPQC or right.t == MPQC))) {
+                mpfr_prec_t prec = std::min(float_prec(left),
+                                            float_prec(right));
+                mpfc_ptr bigcomplex;
+                mpfc_init2(bigcomplex, prec);
+                mpfc_set_numeric(bigcomplex, left);
+                new_left = numeric(bigcomplex);
+                mpfc_init2(bigcomplex, prec);
+                mpfc_set_numeric(bigcomplex, right);
+                new_right = numeric(bigcomplex);
+                return;
+        }
+        // Exact real numbers next to a Gaussian rational get a zero
+        // imaginary part.  Such a numeric only lives during the operation.
+        if (left.t == MPQC or right.t == MPQC) {
+                const numeric& x = (left.t == MPQC) ? right : left;
+                numeric& new_x = (left.t == MPQC) ? new_right : new_left;
+                numeric& new_z = (left.t == MPQC) ? new_left : new_right;
+                new_z = (left.t == MPQC) ? left : right;
+                numeric n;
+                n.t = MPQC;
+                mpqc_init(n.v._gaussrat);
+                mpqc_set_numeric(n.v._gaussrat, x);
+                n.hash = hash_pending;
+                new_x = n;
+                return;
+        }
+        // Exact numbers are rounded to the precision of an MPFR float.
+        if (left.t == MPFR or right.t == MPFR) {
+                const numeric& f = (left.t == MPFR) ? left : right;
+                const numeric& x = (left.t == MPFR) ? right : left;
+                numeric& new_f = (left.t == MPFR) ? new_left : new_right;
+                numeric& new_x = (left.t == MPFR) ? new_right : new_left;
+                mpfr_t bigfloat;
+                mpfr_init2(bigfloat, mpfr_get_prec(f.v._bigfloat));
+                mpfr_set_numeric(bigfloat, x);
+                new_x = numeric(bigfloat);
+                new_f = f;
+                return;
+        }
         PyObject *o;
         switch (left.t) {
         case LONG:
@@ -5135,6 +7054,21 @@ const numeric isqrt(const numeric &x) {
 
 /** Floating point evaluation of Sage's constants. */
 ex ConstantEvalf(unsigned serial, PyObject* dict) {
+        if (dict == nullptr and evalf_mpfr_prec > 0) {
+                int (*f)(mpfr_ptr, mpfr_rnd_t) = nullptr;
+                if (serial == Pi.get_serial())
+                        f = mpfr_const_pi;
+                else if (serial == Euler.get_serial())
+                        f = mpfr_const_euler;
+                else if (serial == Catalan.get_serial())
+                        f = mpfr_const_catalan;
+                if (f != nullptr) {
+                        mpfr_t bigfloat;
+                        mpfr_init2(bigfloat, evalf_mpfr_prec);
+                        f(bigfloat, MPFR_RNDN);
+                        return numeric(bigfloat);
+                }
+        }
         if (dict == nullptr) {
                 dict = PyDict_New();
                 PyDict_SetItemString(dict, "parent", CC_get());
@@ -51,6 +51,7 @@
 #include "ex.h"
 
 #include <gmp.h>
+#include <mpfr.h>
 #include <limits>
 #include <stdexcept>
 #include <vector>
@@ -72,14 +73,39 @@ namespace giac {
 
 namespace GiNaC {
 
+/** Complex MPFR float re+im*I, both parts having the same precision. */
+typedef struct {
+	mpfr_t re;
+	mpfr_t im;
+} mpfc_struct;
+typedef mpfc_struct *mpfc_ptr;
+typedef const mpfc_struct *mpfc_srcptr;
+
+/** Exact Gaussian rational re+im*I.  A numeric of type MPQC always has
+ *  a nonzero imaginary part, otherwise it is stored as a real number. */
+typedef struct {
+	mpq_t re;
+	mpq_t im;
+} mpqc_struct;
+typedef mpqc_struct *mpqc_ptr;
+typedef const mpqc_struct *mpqc_srcptr;
+
+/** Complex ball of Arb, a midpoint-radius enclosure of a number, with the
+ *  precision in bits used for operations on it.  Real balls have an exact
+ *  zero imaginary part. */
+struct ball_struct;  // defined in ball.h
+typedef ball_struct *ball_ptr;
+typedef const ball_struct *ball_srcptr;
+
 enum Type {
 	LONG=1,
 	PYOBJECT,
 	MPZ,
 	MPQ,
-//	MPFR,
-//	MPFC,
-//	MPQC
+	MPFR,
+	MPFC,
+	MPQC,
+	ACB
 };
 
 union Value {
@@ -88,6 +114,10 @@ union Value {
 	signed long int _long;
 	mpz_t _bigint;
 	mpq_t _bigrat;
+	mpfr_t _bigfloat;
+	mpfc_ptr _bigcomplex;
+	mpqc_ptr _gaussrat;
+	ball_ptr _ball;
 	PyObject* _pyobject;
 };
 
@@ -131,6 +161,10 @@ public:
 	numeric(double d);
 	numeric(mpz_t bigint);
 	numeric(mpq_t bigrat);
+	numeric(mpfr_t bigfloat);
+	numeric(mpfc_ptr bigcomplex);
+	numeric(mpqc_ptr gaussrat);
+	numeric(ball_ptr ball);
 	numeric(PyObject*, bool=false);
         static ex unarchive(const archive_node &n, lst &sym_lst)
         {
@@ -157,6 +191,10 @@ public:
         bool is_long() const     { return t == LONG; }
 	bool is_mpz() const      { return t == MPZ; }
 	bool is_mpq() const      { return t == MPQ; }
+	bool is_mpfr() const     { return t == MPFR; }
+	bool is_mpfc() const     { return t == MPFC; }
+	bool is_mpqc() const     { return t == MPQC; }
+	bool is_ball() const     { return t == ACB; }
         bool is_pyobject() const { return t == PYOBJECT; }
 	bool is_zero() const;
 	bool is_inexact_one() const;
@@ -184,6 +222,7 @@ public:
 	bool has(const ex &other, unsigned options = 0) const override;
 	ex eval(int level = 0) const override;
 	ex evalf(int level = 0, PyObject* parent = nullptr) const override;
+	const numeric to_ball(long prec) const;
 
 	ex subs(const exmap & m, unsigned options = 0) const override;
 	ex normal(exmap & repl, exmap & rev_lookup, int level = 0, unsigned options = 0) const override;
@@ -217,6 +256,13 @@ public:
 	const numeric & mul_dyn(const numeric &other) const;
 	const numeric & div_dyn(const numeric &other) const;
 	const numeric & power_dyn(const numeric &other) const;
+	numeric & add_to(const numeric &other);
+	numeric & mul_by(const numeric &other);
+	/** True if no other ex refers to this number, so that add_to() and
+	 *  mul_by() may change it in place. */
+	bool is_unshared() const
+	{ return get_refcount() == 1
+	         and (flags & status_flags::interned) == 0u; }
 	const numeric & operator=(int i);
 	const numeric & operator=(unsigned int i);
 	const numeric & operator=(long i);
@@ -240,6 +286,8 @@ public:
         const numeric to_bigint() const;
         const mpz_t& as_mpz() const;
         const mpq_t& as_mpq() const;
+        const mpfr_t& as_mpfr() const;
+        ball_srcptr as_ball() const;
         void canonicalize();
         PyObject* to_pyobject() const;
         const numeric try_py_method(const std::string& s) const;
@@ -325,7 +373,7 @@ public:
 
     Type t;
     Value v;
-    long hash;
+    mutable long hash;  // computed lazily for MPZ, MPQ and MPQC, see calchash()
     bool is_hashable = true;
 };
 
@@ -379,6 +427,12 @@ const numeric iquo(const numeric &a, const numeric &b, numeric &r);
 const numeric gcd(const numeric &a, const numeric &b);
 const numeric lcm(const numeric &a, const numeric &b);
 
+/** Precision in bits of the MPFR floats produced by evalf() when no parent
+ *  is given.  Zero, the default, makes evalf() produce elements of Sage's
+ *  RR instead. */
+void set_evalf_mpfr_precision(long prec);
+long evalf_mpfr_precision();
+
 // wrapper functions around member functions
 
 inline ex pow(const numeric &x, const numeric &y)
@@ -0,0 +1,89 @@
+/** @file parallel.cpp
+ *
+ *  Helpers for running parts of algorithms on several threads. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "parallel.h"
+
+#include <atomic>
+#include <mutex>
+#include <system_error>
+
+namespace GiNaC {
+
+namespace {
+
+std::atomic<unsigned> max_threads(0);
+
+} // anonymous namespace
+
+void set_parallel_threads(unsigned n)
+{
+	max_threads.store(n, std::memory_order_relaxed);
+}
+
+unsigned parallel_threads()
+{
+	unsigned n = max_threads.load(std::memory_order_relaxed);
+	if (n == 0)
+		n = std::thread::hardware_concurrency();
+	return n == 0 ? 1 : n;
+}
+
+void parallel_for(size_t n, const std::function<void(size_t)> & f)
+{
+	const size_t nthreads = std::min<size_t>(parallel_threads(), n);
+	if (nthreads <= 1) {
+		for (size_t i = 0; i < n; ++i)
+			f(i);
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	std::exception_ptr error;
+	std::mutex error_mutex;
+	auto work = [&]() {
+		size_t i;
+		while ((i = next.fetch_add(1, std::memory_order_relaxed)) < n) {
+			try {
+				f(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(error_mutex);
+				if (not error)
+					error = std::current_exception();
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(nthreads - 1);
+	for (size_t t = 1; t < nthreads; ++t) {
+		try {
+			threads.emplace_back(work);
+		} catch (const std::system_error &) {
+			break;  // make do with the threads we have
+		}
+	}
+	work();
+	for (auto & t : threads)
+		t.join();
+	if (error)
+		std::rethrow_exception(error);
+}
+
+} // namespace GiNaC
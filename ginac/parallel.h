@@ -0,0 +1,87 @@
+/** @file parallel.h
+ *
+ *  Helpers for running parts of algorithms on several threads.
+ *
+ *  Expressions must not be created, copied or destroyed by the worker
+ *  threads unless pynac was configured with --enable-threadsafe-refcount,
+ *  and numerics holding Python objects must never be touched by them.
+ *  Callers therefore usually prepare plain data (hash values, indices,
+ *  machine numbers) first and only hand that to the workers. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_PARALLEL_H__
+#define __PYNAC_PARALLEL_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace GiNaC {
+
+/** Set the maximal number of threads used by parallel algorithms.  Zero
+ *  (the default) means one per hardware thread, one switches them off. */
+void set_parallel_threads(unsigned n);
+unsigned parallel_threads();
+
+/** Call f(i) for every i in [0, n), distributing the calls over up to
+ *  parallel_threads() threads, one of which is the calling thread.  If
+ *  calls throw, the first exception is rethrown after all calls are done. */
+void parallel_for(size_t n, const std::function<void(size_t)> & f);
+
+/** Sort [first, last) by sorting chunks in parallel and merging them in
+ *  parallel rounds.  The comparison must be safe to call concurrently. */
+template <class RandomIt, class Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp)
+{
+	const size_t n = last - first;
+	size_t chunks = std::min<size_t>(parallel_threads(), n / 1024);
+	if (chunks < 2) {
+		std::sort(first, last, comp);
+		return;
+	}
+
+	std::vector<size_t> bounds(chunks + 1);
+	for (size_t i = 0; i <= chunks; ++i)
+		bounds[i] = n * i / chunks;
+	parallel_for(chunks, [&](size_t i) {
+		std::sort(first + bounds[i], first + bounds[i+1], comp);
+	});
+
+	// merge neighbouring runs until one is left
+	while (bounds.size() > 2) {
+		const size_t runs = bounds.size() - 1;
+		parallel_for(runs / 2, [&](size_t i) {
+			std::inplace_merge(first + bounds[2*i],
+			                   first + bounds[2*i+1],
+			                   first + bounds[2*i+2], comp);
+		});
+		std::vector<size_t> merged;
+		for (size_t i = 0; i < runs; i += 2)
+			merged.push_back(bounds[i]);
+		merged.push_back(n);
+		bounds.swap(merged);
+	}
+}
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_PARALLEL_H__
@@ -37,8 +37,10 @@
 #include "compiler.h"
 #include "cmatcher.h"
 #include "wildcard.h"
+#include "parallel.h"
 
 #include <unistd.h>
+#include <iterator>
 #include <vector>
 #include <stdexcept>
 #include <limits>
@@ -1222,6 +1224,31 @@ multinomial_coefficient(const std::vector<int> & p)
 	return factorial(n) / d;
 }
 
+// Multinomial expansions with at least this many terms may use threads.
+const long parallel_expand_min_terms = 10000;
+
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+/** Whether e is a symbol or a power of a symbol with integer exponent,
+ *  or a product of such. */
+bool is_symbol_monomial(const ex & e)
+{
+	if (is_exactly_a<symbol>(e))
+		return true;
+	if (is_exactly_a<power>(e))
+		return is_exactly_a<symbol>(e.op(0))
+		        and is_exactly_a<numeric>(e.op(1))
+		        and ex_to<numeric>(e.op(1)).is_integer();
+	if (is_exactly_a<mul>(e)) {
+		for (size_t i = 0; i < e.nops(); ++i)
+			if (not is_exactly_a<numeric>(e.op(i))
+			    and not is_symbol_monomial(e.op(i)))
+				return false;
+		return true;
+	}
+	return false;
+}
+#endif
+
 }  // anonymous namespace
 
 /** expand a^n where a is an add and n is a positive integer.
@@ -1289,12 +1316,24 @@ ex power::expand_add(const add & a, long n, unsigned options) const
 	// which sum up to n.  It is frequently written as C_n(m) and directly
 	// related with binomial coefficients: binomial(n+m-1,m-1).
         long anops = a.nops() - 1;
-	long result_size = numeric::binomial(n + anops, anops).to_long();
+	const numeric num_terms = numeric::binomial(n + anops, anops);
+	check_expand_budget(num_terms.is_long() ? num_terms.to_long()
+	                    : std::numeric_limits<size_t>::max());
+	long result_size = num_terms.to_long();
 	if (not a.overall_coeff.is_zero()) {
 		// the result's overall_coeff is one of the terms
 		--result_size;
 	}
-	result.reserve(result_size);
+
+	// Collect all partitions, together with their coefficients, first.
+	// The compositions of each partition can then be expanded
+	// independently of the others.
+	struct partition_job {
+		std::vector<int> partition;
+		numeric coef;
+		unsigned msize;
+	};
+	std::vector<partition_job> jobs;
 
 	// Iterate over all terms in binomial expansion of
 	// S = power(+(x,...,z;c),n)
@@ -1323,44 +1362,79 @@ ex power::expand_add(const add & a, long n, unsigned options) const
 			const std::vector<int>& partition = partitions.current();
 			// All monomials of this partition have the same number of terms and the same coefficient.
 			const unsigned msize = std::count_if(partition.begin(), partition.end(), [](int i) { return i > 0; });
-			const numeric coef = multinomial_coefficient(partition) * binomial_coefficient;
-
-			// Iterate over all compositions of the current partition.
-			composition_generator compositions(partition);
-			do {
-				const std::vector<int>& the_exponent = compositions.current();
-				epvector monomial;
-				monomial.reserve(msize);
-				numeric factor = coef;
-				for (unsigned i = 0; i < the_exponent.size(); ++i) {
-					const ex & r = a.seq[i].rest;
-					GINAC_ASSERT(!is_exactly_a<add>(r));
-					GINAC_ASSERT(!is_exactly_a<power>(r) ||
-						     !is_exactly_a<numeric>(ex_to<power>(r).exponent) ||
-						     !ex_to<numeric>(ex_to<power>(r).exponent).is_pos_integer() ||
-						     !is_exactly_a<add>(ex_to<power>(r).basis) ||
-						     !is_exactly_a<mul>(ex_to<power>(r).basis) ||
-						     !is_exactly_a<power>(ex_to<power>(r).basis));
-					GINAC_ASSERT(is_exactly_a<numeric>(a.seq[i].coeff));
-					const numeric & c = ex_to<numeric>(a.seq[i].coeff);
-					if (the_exponent[i] == 0) {
-						// optimize away
-					} else if (the_exponent[i] == 1) {
-						// optimized
-						monomial.emplace_back(r, _ex1);
-						if (not c.is_one())
-							factor = factor.mul(c);
-					} else { // general case exponent[i] > 1
-						monomial.emplace_back(r, the_exponent[i]);
-						if (not c.is_one())
-							factor = factor.mul(c.pow_intexp(the_exponent[i]));
-					}
-				}
-				result.emplace_back(mul(std::move(monomial)).expand(options), factor);
-			} while (compositions.next());
+			jobs.push_back(partition_job{partition,
+			                             multinomial_coefficient(partition) * binomial_coefficient,
+			                             msize});
 		} while (partitions.next());
 	}
 
+	// Iterate over all compositions of a partition.
+	auto expand_partition = [&](const partition_job & job, epvector & terms) {
+		composition_generator compositions(job.partition);
+		do {
+			const std::vector<int>& the_exponent = compositions.current();
+			epvector monomial;
+			monomial.reserve(job.msize);
+			numeric factor = job.coef;
+			for (unsigned i = 0; i < the_exponent.size(); ++i) {
+				const ex & r = a.seq[i].rest;
+				GINAC_ASSERT(!is_exactly_a<add>(r));
+				GINAC_ASSERT(!is_exactly_a<power>(r) ||
+					     !is_exactly_a<numeric>(ex_to<power>(r).exponent) ||
+					     !ex_to<numeric>(ex_to<power>(r).exponent).is_pos_integer() ||
+					     !is_exactly_a<add>(ex_to<power>(r).basis) ||
+					     !is_exactly_a<mul>(ex_to<power>(r).basis) ||
+					     !is_exactly_a<power>(ex_to<power>(r).basis));
+				GINAC_ASSERT(is_exactly_a<numeric>(a.seq[i].coeff));
+				const numeric & c = ex_to<numeric>(a.seq[i].coeff);
+				if (the_exponent[i] == 0) {
+					// optimize away
+				} else if (the_exponent[i] == 1) {
+					// optimized
+					monomial.emplace_back(r, _ex1);
+					if (not c.is_one())
+						factor = factor.mul(c);
+				} else { // general case exponent[i] > 1
+					monomial.emplace_back(r, the_exponent[i]);
+					if (not c.is_one())
+						factor = factor.mul(c.pow_intexp(the_exponent[i]));
+				}
+			}
+			terms.emplace_back(mul(std::move(monomial)).expand(options), factor);
+		} while (compositions.next());
+	};
+
+	bool parallel = false;
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+	// The compositions may be expanded on several threads if all terms
+	// are monomials in symbols with rational coefficients, so that the
+	// threads neither call into Python nor evaluate functions.
+	if (result_size >= parallel_expand_min_terms and parallel_threads() > 1) {
+		parallel = a.overall_coeff.is_rational();
+		for (const auto & p : a.seq) {
+			if (not parallel)
+				break;
+			parallel = ex_to<numeric>(p.coeff).is_rational()
+			        and is_symbol_monomial(p.rest);
+			// compute hash values now, so the threads only read them
+			p.rest.gethash();
+		}
+	}
+#endif
+
+	if (parallel) {
+		std::vector<epvector> parts(jobs.size());
+		parallel_for(jobs.size(), [&](size_t i) {
+			expand_partition(jobs[i], parts[i]);
+		});
+		result.reserve(result_size);
+		for (auto & part : parts)
+			std::move(part.begin(), part.end(), std::back_inserter(result));
+	} else {
+		result.reserve(result_size);
+		for (const auto & job : jobs)
+			expand_partition(job, result);
+	}
 
 	GINAC_ASSERT(result.size() == result_size);
 	if (a.overall_coeff.is_zero()) {
@@ -1377,6 +1451,7 @@ ex power::expand_add_2(const add & a, unsigned options) const
 {
 	epvector result;
 	size_t result_size = (a.nops() * (a.nops()+1)) / 2;
+	check_expand_budget(result_size);
 	if (!a.overall_coeff.is_zero()) {
 		// the result's overall_coeff is one of the terms
 		--result_size;
@@ -54,6 +54,11 @@ print_python_repr::print_python_repr()
 print_python_repr::print_python_repr(std::ostream & os, unsigned opt)
 	: print_context(os, opt) {}
 
+print_csrc::print_csrc()
+	: print_context(std::cout), type(ctype_double) {}
+print_csrc::print_csrc(std::ostream & os, csrc_type t, unsigned opt)
+	: print_context(os, opt), type(t) {}
+
 print_tree::print_tree()
 	: print_context(std::cout), delta_indent(4) {}
 print_tree::print_tree(unsigned d)
@@ -154,6 +154,23 @@ public:
 	const unsigned delta_indent; /**< size of indentation step */
 };
 
+/** Context for C source output, in double or MPFR arithmetic.  It is
+ *  only meant for print_csrc_function(); no class has print methods for
+ *  it, so ex::print() with it gives the default output. */
+class print_csrc : public print_context_base<print_csrc>
+{
+public:
+	enum csrc_type {
+		ctype_double,   ///< double arithmetic and the C math library
+		ctype_mpfr      ///< MPFR floats at the precision of the result
+	};
+
+	print_csrc();
+	print_csrc(std::ostream &, csrc_type t = ctype_double, unsigned options = 0);
+
+	const csrc_type type; /**< arithmetic of the generated code */
+};
+
 /** Check if obj is a T, including base classes. */
 template <class T>
 inline bool is_a(const print_context & obj)
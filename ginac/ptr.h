@@ -26,27 +26,120 @@
 #include <cstddef> // for size_t
 #include <functional>
 #include <iosfwd>
+#include <vector>
 
+#include "pynac-config.h"
 #include "assertion.h"
 
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+#include <atomic>
+#endif
+
 namespace GiNaC {
 
 
-/** Base class for reference-counted objects. */
+/** Base class for reference-counted objects.
+ *
+ *  If pynac was configured with --enable-threadsafe-refcount the counter
+ *  is updated atomically, so that evaluated expressions may be shared
+ *  read-only between threads.  Otherwise a plain integer is used, which is
+ *  faster but restricts every expression to the thread that created it. */
 class refcounted {
 public:
 	refcounted() throw() : refcount(0) {}
 
+#ifdef PYNAC_THREADSAFE_REFCOUNT
+	// A copy is a new object nobody refers to yet.
+	refcounted(const refcounted &) throw() : refcount(0) {}
+	refcounted & operator=(const refcounted &) throw() { return *this; }
+
+	size_t add_reference() throw()
+	{
+		return refcount.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+	size_t remove_reference() throw()
+	{
+		// acq_rel: the thread dropping the last reference must see all
+		// writes of the other owners before it deletes the object
+		return refcount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+	}
+	/** Add a reference unless the object is already being destroyed. */
+	bool try_add_reference() throw()
+	{
+		size_t r = refcount.load(std::memory_order_relaxed);
+		do {
+			if (r == 0)
+				return false;
+		} while (not refcount.compare_exchange_weak(r, r + 1, std::memory_order_relaxed));
+		return true;
+	}
+	size_t get_refcount() const throw() { return refcount.load(std::memory_order_acquire); }
+	void set_refcount(size_t r) throw() { refcount.store(r, std::memory_order_relaxed); }
+
+private:
+	std::atomic<size_t> refcount; ///< reference counter
+#else
 	size_t add_reference() throw() { return ++refcount; }
 	size_t remove_reference() throw() { return --refcount; }
+	/** Add a reference unless the object is already being destroyed. */
+	bool try_add_reference() throw() { return refcount != 0 and ++refcount != 0; }
 	size_t get_refcount() const throw() { return refcount; }
 	void set_refcount(size_t r) throw() { refcount = r; }
 
 private:
 	size_t refcount; ///< reference counter
+#endif
 };
 
 
+/** Deletes objects whose reference count dropped to zero.
+ *
+ *  Deleting an expression releases its operands, which may then be deleted
+ *  as well, and so on.  Done naively this recurses once per level of the
+ *  tree, which is slow and can overflow the stack for deeply nested
+ *  expressions.  Instead, objects released while another one is being
+ *  deleted by the same thread are queued, and the outermost call deletes
+ *  them one after the other. */
+template <class T> class release_queue {
+public:
+	static void release(T *p)
+	{
+		if (state == dead) {
+			// the thread is exiting and the queue is gone
+			delete p;
+			return;
+		}
+		release_queue & q = instance;
+		if (q.busy) {
+			q.pending.push_back(p);
+			return;
+		}
+		q.busy = true;
+		delete p;
+		while (not q.pending.empty()) {
+			T *next = q.pending.back();
+			q.pending.pop_back();
+			delete next;
+		}
+		q.busy = false;
+	}
+
+private:
+	release_queue() : busy(false) { state = alive; }
+	~release_queue() { state = dead; }
+
+	enum { unused = 0, alive, dead };
+	static thread_local int state;
+	static thread_local release_queue instance;
+
+	std::vector<T *> pending;
+	bool busy;
+};
+
+template <class T> thread_local int release_queue<T>::state = release_queue<T>::unused;
+template <class T> thread_local release_queue<T> release_queue<T>::instance;
+
+
 /** Class of (intrusively) reference-counted pointers that support
  *  copy-on-write semantics.
  *
@@ -57,9 +150,11 @@ private:
 template <class T> class ptr {
 	friend struct std::less< ptr<T> >;
 
-	// NB: This implementation of reference counting is not thread-safe.
-	// The reference counter needs to be incremented/decremented atomically,
-	// and makewritable() requires locking.
+	// NB: Reference counting is only thread-safe if PYNAC_THREADSAFE_REFCOUNT
+	// is defined (see class refcounted).  makewritable() needs no lock then:
+	// a refcount of 1 means that this ptr is the sole owner and no other
+	// thread can obtain a new reference behind our back, while for shared
+	// objects we only read the old object in order to duplicate it.
 
 public:
     // no default ctor: a ptr is never unbound
@@ -77,7 +172,7 @@ public:
 		// if the constructor of p fails, we get a null pointer
 		// which leads to a segfault while calling remove_reference
 		if (p && p->remove_reference() == 0)
-			delete p;
+			release_queue<T>::release(p);
 	}
 
 	ptr &operator=(const ptr & other)
@@ -88,7 +183,7 @@ public:
 		T *otherp = other.p;
 		otherp->add_reference();
 		if (p->remove_reference() == 0)
-			delete p;
+			release_queue<T>::release(p);
 		p = otherp;
 		return *this;
 	}
@@ -105,7 +200,9 @@ public:
 		if (p->get_refcount() > 1) {
 			T *p2 = p->duplicate();
 			p2->set_refcount(1);
-			p->remove_reference();
+			// other owners may have let go in the meantime
+			if (p->remove_reference() == 0)
+				release_queue<T>::release(p);
 			p = p2;
 		}
 	}
@@ -338,8 +338,8 @@ long relational::calchash() const
 
 	// store calculated hash value only if object is already evaluated
 	if (is_evaluated()) {
-		setflag(status_flags::hash_calculated);
 		hashvalue = v;
+		setflag(status_flags::hash_calculated);
 	}
 
 	return v;
@@ -0,0 +1,516 @@
+/** @file sparse_poly.cpp
+ *
+ *  Implementation of sparse multivariate polynomials with packed
+ *  monomials. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sparse_poly.h"
+#include "add.h"
+#include "mul.h"
+#include "power.h"
+#include "symbol.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace GiNaC {
+
+//////////
+// reading expressions
+//////////
+
+sparse_poly::reader::reader(const exvector & vars)
+  : symbols(vars), fixed(true)
+{
+	for (size_t i=0; i<vars.size(); ++i)
+		index.emplace(vars[i], i);
+}
+
+bool sparse_poly::reader::symbol_index(const ex & s, unsigned & i)
+{
+	auto it = index.find(s);
+	if (it == index.end()) {
+		if (fixed)
+			return false;
+		it = index.emplace(s, symbols.size()).first;
+		symbols.push_back(s);
+	}
+	i = it->second;
+	return true;
+}
+
+// Exponents must be small positive integers.
+static bool small_pos_exponent(const ex & e)
+{
+	if (not is_exactly_a<numeric>(e))
+		return false;
+	const numeric & n = ex_to<numeric>(e);
+	return n.is_long() and n.to_long() > 0 and n.to_long() < (1L << 30);
+}
+
+/** Read a product of powers of symbols into ev and multiply its numeric
+ *  factor into c. */
+bool sparse_poly::reader::read_term(const ex & e, expvec & ev, numeric & c)
+{
+	unsigned i;
+	if (is_exactly_a<symbol>(e)) {
+		if (not symbol_index(e, i))
+			return false;
+		ev.emplace_back(i, 1);
+		return true;
+	}
+	if (is_exactly_a<power>(e)) {
+		const ex & basis = e.op(0);
+		const ex & expo = e.op(1);
+		if (not is_exactly_a<symbol>(basis) or not small_pos_exponent(expo)
+		    or not symbol_index(basis, i))
+			return false;
+		ev.emplace_back(i, ex_to<numeric>(expo).to_long());
+		return true;
+	}
+	if (is_exactly_a<GiNaC::mul>(e)) {
+		const GiNaC::mul & m = ex_to<GiNaC::mul>(e);
+		if (not m.overall_coeff.is_rational())
+			return false;
+		for (const auto & p : m.seq) {
+			if (not is_exactly_a<symbol>(p.rest)
+			    or not small_pos_exponent(p.coeff)
+			    or not symbol_index(p.rest, i))
+				return false;
+			ev.emplace_back(i, ex_to<numeric>(p.coeff).to_long());
+		}
+		if (not m.overall_coeff.is_one())
+			c = c.mul(m.overall_coeff);
+		return true;
+	}
+	return false;
+}
+
+bool sparse_poly::reader::read(const ex & e, std::vector<expvec> & terms,
+                               std::vector<numeric> & coeffs)
+{
+	if (is_exactly_a<numeric>(e)) {
+		const numeric & c = ex_to<numeric>(e);
+		if (not c.is_rational())
+			return false;
+		if (not c.is_zero()) {
+			terms.emplace_back();
+			coeffs.push_back(c);
+		}
+		return true;
+	}
+	if (not is_exactly_a<GiNaC::add>(e)) {
+		terms.emplace_back();
+		coeffs.push_back(*_num1_p);
+		return read_term(e, terms.back(), coeffs.back());
+	}
+
+	const GiNaC::add & a = ex_to<GiNaC::add>(e);
+	terms.reserve(a.seq.size() + 1);
+	coeffs.reserve(a.seq.size() + 1);
+	for (const auto & p : a.seq) {
+		const numeric & c = ex_to<numeric>(p.coeff);
+		if (not c.is_rational())
+			return false;
+		terms.emplace_back();
+		coeffs.push_back(c);
+		if (not read_term(p.rest, terms.back(), coeffs.back()))
+			return false;
+	}
+	if (not a.overall_coeff.is_rational())
+		return false;
+	if (not a.overall_coeff.is_zero()) {
+		terms.emplace_back();
+		coeffs.push_back(a.overall_coeff);
+	}
+	return true;
+}
+
+//////////
+// construction and packing
+//////////
+
+sparse_poly::sparse_poly(const exvector & v)
+  : vars(v), bits(field_bits(v.size()))
+{
+	if (vars.size() > 64)
+		throw std::invalid_argument("sparse_poly: more than 64 variables");
+	for (size_t i=0; i<vars.size(); ++i) {
+		if (not is_exactly_a<symbol>(vars[i]))
+			throw std::invalid_argument("sparse_poly: variables must be symbols");
+		for (size_t j=0; j<i; ++j)
+			if (vars[j].is_equal(vars[i]))
+				throw std::invalid_argument("sparse_poly: variables must be distinct");
+	}
+}
+
+sparse_poly::sparse_poly(const ex & e, const exvector & v)
+  : sparse_poly(v)
+{
+	reader r(vars);
+	std::vector<expvec> terms;
+	std::vector<numeric> cs;
+	if (not r.read(e.expand(), terms, cs))
+		throw std::invalid_argument("sparse_poly: not a polynomial with rational coefficients in the given variables");
+	if (not pack(terms, cs))
+		throw std::overflow_error("sparse_poly: exponent too large");
+}
+
+unsigned sparse_poly::field_bits(size_t nvars)
+{
+	if (nvars == 0)
+		return 32;
+	return std::min(64 / nvars, size_t(32));
+}
+
+/** Set the terms from exponent lists, sorting them and combining equal
+ *  monomials.  Returns false if an exponent does not fit into a field. */
+bool sparse_poly::pack(const std::vector<expvec> & terms,
+                       const std::vector<numeric> & cs)
+{
+	std::vector<std::pair<uint64_t, size_t>> order;
+	order.reserve(terms.size());
+	for (size_t i=0; i<terms.size(); ++i) {
+		uint64_t m = 0;
+		for (const auto & ve : terms[i]) {
+			const uint64_t e = ((m >> shift(ve.first)) & field_mask()) + ve.second;
+			if (e > field_mask())
+				return false;
+			m = (m & ~(field_mask() << shift(ve.first))) | (e << shift(ve.first));
+		}
+		order.emplace_back(m, i);
+	}
+	std::sort(order.begin(), order.end(),
+	          [](const std::pair<uint64_t, size_t> & x,
+	             const std::pair<uint64_t, size_t> & y)
+	          { return x.first > y.first; });
+
+	mons.clear();
+	coeffs.clear();
+	mons.reserve(order.size());
+	coeffs.reserve(order.size());
+	for (size_t i=0; i<order.size(); ) {
+		numeric c = cs[order[i].second];
+		size_t j = i + 1;
+		for (; j<order.size() and order[j].first == order[i].first; ++j)
+			c = c.add(cs[order[j].second]);
+		if (not c.is_zero())
+			push_term(order[i].first, c);
+		i = j;
+	}
+	return true;
+}
+
+//////////
+// monomials
+//////////
+
+unsigned sparse_poly::degree(size_t v) const
+{
+	unsigned d = 0;
+	for (uint64_t m : mons)
+		d = std::max(d, field(m, v));
+	return d;
+}
+
+std::vector<uint64_t> sparse_poly::max_exponents() const
+{
+	std::vector<uint64_t> d(vars.size());
+	for (uint64_t m : mons)
+		for (size_t v=0; v<vars.size(); ++v)
+			d[v] = std::max(d[v], static_cast<uint64_t>(field(m, v)));
+	return d;
+}
+
+/** Whether no exponent of the product with other overflows its field. */
+bool sparse_poly::product_fits(const sparse_poly & other) const
+{
+	const std::vector<uint64_t> d1 = max_exponents();
+	const std::vector<uint64_t> d2 = other.max_exponents();
+	for (size_t v=0; v<vars.size(); ++v)
+		if (d1[v] + d2[v] > field_mask())
+			return false;
+	return true;
+}
+
+/** Whether the monomial d divides the monomial m. */
+bool sparse_poly::divides(uint64_t d, uint64_t m) const
+{
+	if (d > m)
+		return false;
+	for (size_t v=0; v<vars.size(); ++v)
+		if (field(d, v) > field(m, v))
+			return false;
+	return true;
+}
+
+void sparse_poly::check_same_ring(const sparse_poly & other) const
+{
+	if (vars.size() != other.vars.size())
+		throw std::invalid_argument("sparse_poly: different variables");
+	for (size_t v=0; v<vars.size(); ++v)
+		if (not vars[v].is_equal(other.vars[v]))
+			throw std::invalid_argument("sparse_poly: different variables");
+}
+
+//////////
+// arithmetic
+//////////
+
+sparse_poly sparse_poly::merge(const sparse_poly & other, bool subtract) const
+{
+	check_same_ring(other);
+	sparse_poly r(vars);
+	r.mons.reserve(mons.size() + other.mons.size());
+	r.coeffs.reserve(mons.size() + other.mons.size());
+	size_t i = 0, j = 0;
+	while (i < mons.size() or j < other.mons.size()) {
+		if (j == other.mons.size()
+		    or (i < mons.size() and mons[i] > other.mons[j])) {
+			r.push_term(mons[i], coeffs[i]);
+			++i;
+		} else if (i == mons.size() or mons[i] < other.mons[j]) {
+			r.push_term(other.mons[j], subtract ? other.coeffs[j].negative()
+			                                    : other.coeffs[j]);
+			++j;
+		} else {
+			const numeric c = subtract ? coeffs[i].sub(other.coeffs[j])
+			                           : coeffs[i].add(other.coeffs[j]);
+			if (not c.is_zero())
+				r.push_term(mons[i], c);
+			++i;
+			++j;
+		}
+	}
+	return r;
+}
+
+sparse_poly sparse_poly::add(const sparse_poly & other) const
+{
+	return merge(other, false);
+}
+
+sparse_poly sparse_poly::sub(const sparse_poly & other) const
+{
+	return merge(other, true);
+}
+
+sparse_poly sparse_poly::mul(const numeric & c) const
+{
+	sparse_poly r(vars);
+	if (c.is_zero())
+		return r;
+	r.mons = mons;
+	r.coeffs.reserve(coeffs.size());
+	for (const auto & a : coeffs)
+		r.coeffs.push_back(a.mul(c));
+	return r;
+}
+
+namespace {
+
+// Heap entry for the product of term i of one factor with term j of the
+// other one.
+struct heap_entry {
+	uint64_t mon;
+	size_t i, j;
+};
+
+inline bool heap_less(const heap_entry & x, const heap_entry & y)
+{
+	return x.mon < y.mon;
+}
+
+} // anonymous namespace
+
+/** Multiply with the heap method of Johnson, Monagan and Pearce.  A heap
+ *  holds, for each term f[i] of the shorter factor, the next product
+ *  f[i]*g[j] not yet taken, so the products come out in decreasing order
+ *  and equal monomials are combined on the fly; the heap never grows
+ *  beyond the number of terms of f. */
+sparse_poly sparse_poly::mul(const sparse_poly & other) const
+{
+	check_same_ring(other);
+	if (not product_fits(other))
+		throw std::overflow_error("sparse_poly::mul(): exponent overflow");
+	const sparse_poly & f = nterms() <= other.nterms() ? *this : other;
+	const sparse_poly & g = nterms() <= other.nterms() ? other : *this;
+
+	sparse_poly h(vars);
+	if (f.is_zero())
+		return h;
+	std::vector<heap_entry> heap;
+	heap.reserve(f.nterms());
+	heap.push_back(heap_entry{f.mons[0] + g.mons[0], 0, 0});
+
+	while (not heap.empty()) {
+		const uint64_t mon = heap.front().mon;
+		numeric c = *_num0_p;
+		do {
+			std::pop_heap(heap.begin(), heap.end(), heap_less);
+			const heap_entry e = heap.back();
+			heap.pop_back();
+			c = c.add(f.coeffs[e.i].mul(g.coeffs[e.j]));
+			if (e.j == 0 and e.i + 1 < f.nterms()) {
+				heap.push_back(heap_entry{f.mons[e.i+1] + g.mons[0], e.i + 1, 0});
+				std::push_heap(heap.begin(), heap.end(), heap_less);
+			}
+			if (e.j + 1 < g.nterms()) {
+				heap.push_back(heap_entry{f.mons[e.i] + g.mons[e.j+1], e.i, e.j + 1});
+				std::push_heap(heap.begin(), heap.end(), heap_less);
+			}
+		} while (not heap.empty() and heap.front().mon == mon);
+		if (not c.is_zero())
+			h.push_term(mon, c);
+	}
+	return h;
+}
+
+/** Exact division with Johnson's heap method.  The terms of this minus
+ *  quotient times divisor are produced in decreasing order; each one that
+ *  does not cancel must be divisible by the leading term of the divisor
+ *  and gives the next term of the quotient.  The heap holds, for each
+ *  quotient term q[j], the next product q[j]*g[i] not yet subtracted. */
+sparse_poly sparse_poly::divexact(const sparse_poly & other) const
+{
+	check_same_ring(other);
+	if (other.is_zero())
+		throw std::overflow_error("sparse_poly::divexact(): division by zero");
+	const sparse_poly & g = other;
+	const uint64_t lm = g.mons[0];
+	const numeric & lc = g.coeffs[0];
+
+	sparse_poly q(vars);
+	std::vector<heap_entry> heap;
+	size_t k = 0;
+	while (k < nterms() or not heap.empty()) {
+		uint64_t mon;
+		numeric c = *_num0_p;
+		if (heap.empty() or (k < nterms() and mons[k] >= heap.front().mon)) {
+			mon = mons[k];
+			c = coeffs[k];
+			++k;
+		} else
+			mon = heap.front().mon;
+		while (not heap.empty() and heap.front().mon == mon) {
+			std::pop_heap(heap.begin(), heap.end(), heap_less);
+			const heap_entry e = heap.back();
+			heap.pop_back();
+			c = c.sub(g.coeffs[e.i].mul(q.coeffs[e.j]));
+			if (e.i + 1 < g.nterms()) {
+				heap.push_back(heap_entry{g.mons[e.i+1] + q.mons[e.j], e.i + 1, e.j});
+				std::push_heap(heap.begin(), heap.end(), heap_less);
+			}
+		}
+		if (c.is_zero())
+			continue;
+		if (not divides(lm, mon))
+			throw std::domain_error("sparse_poly::divexact(): division is not exact");
+		q.push_term(mon - lm, c.div(lc));
+		if (g.nterms() > 1) {
+			heap.push_back(heap_entry{g.mons[1] + q.mons.back(), 1, q.nterms() - 1});
+			std::push_heap(heap.begin(), heap.end(), heap_less);
+		}
+	}
+	return q;
+}
+
+//////////
+// evaluation and conversion
+//////////
+
+// Powers up to this exponent are tabulated by evaluate().
+static const uint64_t max_tabulated_power = 256;
+
+numeric sparse_poly::evaluate(const std::vector<numeric> & values) const
+{
+	if (values.size() != vars.size())
+		throw std::invalid_argument("sparse_poly::evaluate(): wrong number of values");
+	const std::vector<uint64_t> d = max_exponents();
+	std::vector<std::vector<numeric>> powers(vars.size());
+	for (size_t v=0; v<vars.size(); ++v) {
+		if (d[v] > max_tabulated_power)
+			continue;
+		powers[v].reserve(d[v] + 1);
+		powers[v].push_back(*_num1_p);
+		for (uint64_t e=1; e<=d[v]; ++e)
+			powers[v].push_back(powers[v].back().mul(values[v]));
+	}
+
+	numeric result = *_num0_p;
+	for (size_t i=0; i<nterms(); ++i) {
+		numeric t = coeffs[i];
+		for (size_t v=0; v<vars.size(); ++v) {
+			const unsigned e = field(mons[i], v);
+			if (e == 0)
+				continue;
+			if (not powers[v].empty())
+				t = t.mul(powers[v][e]);
+			else
+				t = t.mul(values[v].power(static_cast<signed long>(e)));
+		}
+		result = result.add(t);
+	}
+	return result;
+}
+
+ex sparse_poly::to_ex() const
+{
+	numeric oc = *_num0_p;
+	epvector terms;
+	terms.reserve(nterms());
+	for (size_t i=0; i<nterms(); ++i) {
+		if (mons[i] == 0) {
+			oc = coeffs[i];
+			continue;
+		}
+		epvector factors;
+		for (size_t v=0; v<vars.size(); ++v) {
+			const unsigned e = field(mons[i], v);
+			if (e != 0)
+				factors.emplace_back(vars[v], numeric(static_cast<long>(e)));
+		}
+		if (factors.size() == 1 and factors[0].coeff.is_one())
+			terms.emplace_back(factors[0].rest, coeffs[i]);
+		else
+			terms.emplace_back((new GiNaC::mul(factors))->setflag(status_flags::dynallocated),
+			                   coeffs[i]);
+	}
+	return (new GiNaC::add(terms, oc))->setflag(status_flags::dynallocated);
+}
+
+bool sparse_poly::expand_product(const GiNaC::add & a, const GiNaC::add & b, ex & result)
+{
+	reader r;
+	std::vector<expvec> terms_a, terms_b;
+	std::vector<numeric> coeffs_a, coeffs_b;
+	if (not r.read(a, terms_a, coeffs_a) or not r.read(b, terms_b, coeffs_b))
+		return false;
+	if (r.symbols.empty() or r.symbols.size() > 64)
+		return false;
+
+	sparse_poly pa(r.symbols), pb(r.symbols);
+	if (not pa.pack(terms_a, coeffs_a) or not pb.pack(terms_b, coeffs_b)
+	    or not pa.product_fits(pb))
+		return false;
+	result = pa.mul(pb).to_ex();
+	return true;
+}
+
+} // namespace GiNaC
@@ -0,0 +1,140 @@
+/** @file sparse_poly.h
+ *
+ *  Interface to sparse multivariate polynomials with packed monomials. */
+
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PYNAC_SPARSE_POLY_H__
+#define __PYNAC_SPARSE_POLY_H__
+
+#include "ex.h"
+#include "numeric.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace GiNaC {
+
+class add;
+
+/** Polynomials with rational coefficients in a fixed list of symbols.
+ *  The exponents of each monomial are packed into one machine word, with
+ *  a field of 64/n bits (at most 32) per variable and the first variable
+ *  in the most significant field.  Comparing and multiplying monomials
+ *  then are single integer operations, and the numeric order of the
+ *  words is the lexicographic order of the monomials.  Monomials and
+ *  coefficients are kept in two arrays, sorted by decreasing monomial.
+ *
+ *  Polynomials can only be combined if they have the same variables.
+ *  Operations whose exponents do not fit into the fields throw
+ *  std::overflow_error. */
+class sparse_poly {
+public:
+	/** The zero polynomial in the given symbols. */
+	explicit sparse_poly(const exvector & vars);
+	/** Convert e, which must expand to a polynomial with rational
+	 *  coefficients in vars.  Throws std::invalid_argument otherwise. */
+	sparse_poly(const ex & e, const exvector & vars);
+
+	const exvector & variables() const { return vars; }
+	size_t nterms() const { return mons.size(); }
+	bool is_zero() const { return mons.empty(); }
+	/** Coefficient of the i-th term. */
+	const numeric & coeff(size_t i) const { return coeffs[i]; }
+	/** Exponent of variable v in the i-th term. */
+	unsigned exponent(size_t i, size_t v) const { return field(mons[i], v); }
+	/** Highest exponent of variable v. */
+	unsigned degree(size_t v) const;
+
+	sparse_poly add(const sparse_poly & other) const;
+	sparse_poly sub(const sparse_poly & other) const;
+	sparse_poly mul(const sparse_poly & other) const;
+	sparse_poly mul(const numeric & c) const;
+	/** Quotient of an exact division.  Throws std::domain_error if
+	 *  other does not divide this polynomial. */
+	sparse_poly divexact(const sparse_poly & other) const;
+	/** Value at the point given by one number per variable. */
+	numeric evaluate(const std::vector<numeric> & values) const;
+	ex to_ex() const;
+
+	/** If a and b are polynomials with rational coefficients in symbols
+	 *  whose product fits into packed monomials, set result to the
+	 *  expanded product and return true.  Otherwise return false. */
+	static bool expand_product(const GiNaC::add & a, const GiNaC::add & b,
+	                           ex & result);
+
+private:
+	// exponents of a monomial while reading, as (symbol index, exponent)
+	typedef std::vector<std::pair<unsigned, uint64_t>> expvec;
+
+	struct reader {
+		exvector symbols;
+		std::unordered_map<ex, unsigned, ex_hash, ex_is_equal> index;
+		bool fixed = false; // no symbols beyond the given ones
+
+		reader() {}
+		explicit reader(const exvector & vars);
+		bool symbol_index(const ex & s, unsigned & i);
+		bool read_term(const ex & e, expvec & ev, numeric & c);
+		bool read(const ex & e, std::vector<expvec> & terms,
+		          std::vector<numeric> & coeffs);
+	};
+
+	static unsigned field_bits(size_t nvars);
+	uint64_t field_mask() const { return (uint64_t(1) << bits) - 1; }
+	unsigned shift(size_t v) const { return bits * (vars.size() - 1 - v); }
+	unsigned field(uint64_t m, size_t v) const
+	{
+		return static_cast<unsigned>((m >> shift(v)) & field_mask());
+	}
+	bool divides(uint64_t d, uint64_t m) const;
+	std::vector<uint64_t> max_exponents() const;
+	bool product_fits(const sparse_poly & other) const;
+	void check_same_ring(const sparse_poly & other) const;
+	bool pack(const std::vector<expvec> & terms, const std::vector<numeric> & cs);
+	sparse_poly merge(const sparse_poly & other, bool subtract) const;
+	void push_term(uint64_t m, const numeric & c)
+	{
+		mons.push_back(m);
+		coeffs.push_back(c);
+	}
+
+	exvector vars;
+	unsigned bits;
+	std::vector<uint64_t> mons;    // in decreasing order
+	std::vector<numeric> coeffs;   // nonzero
+};
+
+inline sparse_poly operator+(const sparse_poly & a, const sparse_poly & b)
+{
+	return a.add(b);
+}
+
+inline sparse_poly operator-(const sparse_poly & a, const sparse_poly & b)
+{
+	return a.sub(b);
+}
+
+inline sparse_poly operator*(const sparse_poly & a, const sparse_poly & b)
+{
+	return a.mul(b);
+}
+
+} // namespace GiNaC
+
+#endif // ndef __PYNAC_SPARSE_POLY_H__
@@ -62,6 +62,9 @@ unsigned log2(unsigned n)
  *  the static flyweights on the heap. */
 int library_init::count = 0;
 
+// static numerics small_int_min ... small_int_max
+const numeric *_num_small_p[small_int_max - small_int_min + 1];
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wuninitialized"
 // static numeric -120
@@ -307,66 +310,74 @@ const ex _ex144 = _ex144;
 library_init::library_init()
 {
 	if (count++==0) {
-		(_num_120_p = new numeric(-120))->setflag(status_flags::dynallocated);
-		(_num_60_p = new numeric(-60))->setflag(status_flags::dynallocated);
-		(_num_48_p = new numeric(-48))->setflag(status_flags::dynallocated);
-		(_num_30_p = new numeric(-30))->setflag(status_flags::dynallocated);
-		(_num_25_p = new numeric(-25))->setflag(status_flags::dynallocated);
-		(_num_24_p = new numeric(-24))->setflag(status_flags::dynallocated);
-		(_num_20_p = new numeric(-20))->setflag(status_flags::dynallocated);
-		(_num_18_p = new numeric(-18))->setflag(status_flags::dynallocated);
-		(_num_15_p = new numeric(-15))->setflag(status_flags::dynallocated);
-		(_num_12_p = new numeric(-12))->setflag(status_flags::dynallocated);
-		(_num_11_p = new numeric(-11))->setflag(status_flags::dynallocated);
-		(_num_10_p = new numeric(-10))->setflag(status_flags::dynallocated);
-		(_num_9_p = new numeric(-9))->setflag(status_flags::dynallocated);
-		(_num_8_p = new numeric(-8))->setflag(status_flags::dynallocated);
-		(_num_7_p = new numeric(-7))->setflag(status_flags::dynallocated);
-		(_num_6_p = new numeric(-6))->setflag(status_flags::dynallocated);
-		(_num_5_p = new numeric(-5))->setflag(status_flags::dynallocated);
-		(_num_4_p = new numeric(-4))->setflag(status_flags::dynallocated);
-		(_num_3_p = new numeric(-3))->setflag(status_flags::dynallocated);
-		(_num_2_p = new numeric(-2))->setflag(status_flags::dynallocated);
-		(_num_1_p = new numeric(-1))->setflag(status_flags::dynallocated);
+		// The table keeps a reference to each of its numbers, so they
+		// are never deleted.
+		for (long i = small_int_min; i <= small_int_max; ++i) {
+			numeric *n = new numeric(i);
+			n->setflag(status_flags::dynallocated);
+			n->add_reference();
+			_num_small_p[i - small_int_min] = n;
+		}
+		_num_120_p = small_int_flyweight(-120);
+		_num_60_p = small_int_flyweight(-60);
+		_num_48_p = small_int_flyweight(-48);
+		_num_30_p = small_int_flyweight(-30);
+		_num_25_p = small_int_flyweight(-25);
+		_num_24_p = small_int_flyweight(-24);
+		_num_20_p = small_int_flyweight(-20);
+		_num_18_p = small_int_flyweight(-18);
+		_num_15_p = small_int_flyweight(-15);
+		_num_12_p = small_int_flyweight(-12);
+		_num_11_p = small_int_flyweight(-11);
+		_num_10_p = small_int_flyweight(-10);
+		_num_9_p = small_int_flyweight(-9);
+		_num_8_p = small_int_flyweight(-8);
+		_num_7_p = small_int_flyweight(-7);
+		_num_6_p = small_int_flyweight(-6);
+		_num_5_p = small_int_flyweight(-5);
+		_num_4_p = small_int_flyweight(-4);
+		_num_3_p = small_int_flyweight(-3);
+		_num_2_p = small_int_flyweight(-2);
+		_num_1_p = small_int_flyweight(-1);
 		(_num_1_2_p = new numeric(-1,2))->setflag(status_flags::dynallocated);
 		(_num_1_3_p = new numeric(-1,3))->setflag(status_flags::dynallocated);
 		(_num_1_4_p = new numeric(-1,4))->setflag(status_flags::dynallocated);
-		(_num0_p = new numeric(0))->setflag(status_flags::dynallocated);
+		_num0_p = small_int_flyweight(0);
 		_num0_bp  = _num0_p;  // Cf. class ex default ctor.
 		(_num1_4_p = new numeric(1,4))->setflag(status_flags::dynallocated);
 		(_num1_3_p = new numeric(1,3))->setflag(status_flags::dynallocated);
 		(_num1_2_p = new numeric(1,2))->setflag(status_flags::dynallocated);
-		(_num1_p = new numeric(1))->setflag(status_flags::dynallocated);
-		(_num2_p = new numeric(2))->setflag(status_flags::dynallocated);
-		(_num3_p = new numeric(3))->setflag(status_flags::dynallocated);
-		(_num4_p = new numeric(4))->setflag(status_flags::dynallocated);
-		(_num5_p = new numeric(5))->setflag(status_flags::dynallocated);
-		(_num6_p = new numeric(6))->setflag(status_flags::dynallocated);
-		(_num7_p = new numeric(7))->setflag(status_flags::dynallocated);
-		(_num8_p = new numeric(8))->setflag(status_flags::dynallocated);
-		(_num9_p = new numeric(9))->setflag(status_flags::dynallocated);
-		(_num10_p = new numeric(10))->setflag(status_flags::dynallocated);
-		(_num11_p = new numeric(11))->setflag(status_flags::dynallocated);
-		(_num12_p = new numeric(12))->setflag(status_flags::dynallocated);
-		(_num14_p = new numeric(14))->setflag(status_flags::dynallocated);
-		(_num15_p = new numeric(15))->setflag(status_flags::dynallocated);
-		(_num16_p = new numeric(16))->setflag(status_flags::dynallocated);
-		(_num18_p = new numeric(18))->setflag(status_flags::dynallocated);
-		(_num20_p = new numeric(20))->setflag(status_flags::dynallocated);
-		(_num21_p = new numeric(21))->setflag(status_flags::dynallocated);
-		(_num22_p = new numeric(22))->setflag(status_flags::dynallocated);
-		(_num24_p = new numeric(24))->setflag(status_flags::dynallocated);
-		(_num25_p = new numeric(25))->setflag(status_flags::dynallocated);
-		(_num26_p = new numeric(26))->setflag(status_flags::dynallocated);
-		(_num27_p = new numeric(27))->setflag(status_flags::dynallocated);
-		(_num28_p = new numeric(28))->setflag(status_flags::dynallocated);
-		(_num30_p = new numeric(30))->setflag(status_flags::dynallocated);
-		(_num36_p = new numeric(36))->setflag(status_flags::dynallocated);
-		(_num48_p = new numeric(48))->setflag(status_flags::dynallocated);
-		(_num60_p = new numeric(60))->setflag(status_flags::dynallocated);
-		(_num72_p = new numeric(72))->setflag(status_flags::dynallocated);
-		(_num120_p = new numeric(120))->setflag(status_flags::dynallocated);
-		(_num144_p = new numeric(144))->setflag(status_flags::dynallocated);
+		_num1_p = small_int_flyweight(1);
+		_num2_p = small_int_flyweight(2);
+		_num3_p = small_int_flyweight(3);
+		_num4_p = small_int_flyweight(4);
+		_num5_p = small_int_flyweight(5);
+		_num6_p = small_int_flyweight(6);
+		_num7_p = small_int_flyweight(7);
+		_num8_p = small_int_flyweight(8);
+		_num9_p = small_int_flyweight(9);
+		_num10_p = small_int_flyweight(10);
+		_num11_p = small_int_flyweight(11);
+		_num12_p = small_int_flyweight(12);
+		_num14_p = small_int_flyweight(14);
+		_num15_p = small_int_flyweight(15);
+		_num16_p = small_int_flyweight(16);
+		_num18_p = small_int_flyweight(18);
+		_num20_p = small_int_flyweight(20);
+		_num21_p = small_int_flyweight(21);
+		_num22_p = small_int_flyweight(22);
+		_num24_p = small_int_flyweight(24);
+		_num25_p = small_int_flyweight(25);
+		_num26_p = small_int_flyweight(26);
+		_num27_p = small_int_flyweight(27);
+		_num28_p = small_int_flyweight(28);
+		_num30_p = small_int_flyweight(30);
+		_num36_p = small_int_flyweight(36);
+		_num48_p = small_int_flyweight(48);
+		_num60_p = small_int_flyweight(60);
+		_num72_p = small_int_flyweight(72);
+		_num120_p = small_int_flyweight(120);
+		_num144_p = small_int_flyweight(144);
 
 		new((void*)&_ex_120) ex(*_num_120_p);
 		new((void*)&_ex_60) ex(*_num_60_p);
@@ -438,6 +449,7 @@ library_init::library_init()
 		print_python::get_class_info_static();
 		print_python_repr::get_class_info_static();
 		print_tree::get_class_info_static();
+		print_csrc::get_class_info_static();
 	}
 }
 
@@ -413,6 +413,23 @@ extern const ex _ex120;
 extern const numeric *_num144_p;
 extern const ex _ex144;
 
+// Every integer in [small_int_min, small_int_max] has a flyweight, which
+// is used instead of allocating a new numeric whenever such a number gets
+// wrapped into an ex (@see ex::construct_from_long(), numeric::add_dyn()).
+const long small_int_min = -256;
+const long small_int_max = 1024;
+extern const numeric *_num_small_p[small_int_max - small_int_min + 1];
+
+inline bool is_small_int(long i)
+{
+	return i >= small_int_min and i <= small_int_max;
+}
+
+inline const numeric *small_int_flyweight(long i)
+{
+	return _num_small_p[i - small_int_min];
+}
+
 
 // Helper macros for class implementations (mostly useful for trivial classes)
 